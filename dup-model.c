@@ -0,0 +1,176 @@
+// This file, dup-model.c, is a part of the Dedupe Entries program.
+// 
+// Copyright (C) 2025  David Hugh
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https:www.gnu.org/licenses/>.
+
+#include "main.h"
+#include "dup-model.h"
+
+// List model interface, rows are made only when asked for
+
+static GType dup_model_get_item_type(GListModel *list)
+{
+	return DUP_TYPE_ITEM;
+}
+
+static guint dup_model_get_n_items(GListModel *list)
+{
+	return DUP_MODEL(list)->order->len;
+}
+
+static gpointer dup_model_get_item(GListModel *list, guint position)
+{
+	DupModel *self = DUP_MODEL(list);
+	if (position >= self->order->len) return NULL;
+	return dup_item_new(self->recs, g_array_index(self->order, uint32_t, position));
+}
+
+static void dup_model_list_init(GListModelInterface *iface)
+{
+	iface->get_item_type = dup_model_get_item_type;
+	iface->get_n_items = dup_model_get_n_items;
+	iface->get_item = dup_model_get_item;
+}
+
+G_DEFINE_TYPE_WITH_CODE(DupModel, dup_model, G_TYPE_OBJECT,
+			G_IMPLEMENT_INTERFACE(G_TYPE_LIST_MODEL, dup_model_list_init))
+
+// Required by boiler plate
+static void dup_model_init(DupModel *self)
+{
+	self->order = g_array_new(FALSE, FALSE, sizeof(uint32_t));
+}
+
+// Release the record array and order
+static void dup_model_finalize(GObject *object)
+{
+	DupModel *self = (DupModel *) object;
+	g_array_unref(self->recs);
+	g_array_unref(self->order);
+	G_OBJECT_CLASS(dup_model_parent_class)->finalize(object);
+}
+
+static void dup_model_class_init(DupModelClass *klass)
+{
+	G_OBJECT_CLASS(klass)->finalize = dup_model_finalize;
+}
+
+// Make a model with no positions
+// - Shares the records if given, otherwise starts an empty record array
+
+DupModel *dup_model_new (GArray *recs)
+{
+	DupModel *self = g_object_new(DUP_TYPE_MODEL, NULL);
+	self->recs = recs ? g_array_ref(recs) : g_array_new(FALSE, TRUE, sizeof(dup_rec));
+	return self;
+}
+
+// Count of positions in the model
+
+uint32_t dup_model_n (DupModel *self)
+{
+	return self->order->len;
+}
+
+// Get the record at a position, loops use this rather than making row objects
+
+dup_rec *dup_model_rec (DupModel *self, uint32_t position)
+{
+	return &g_array_index(self->recs, dup_rec, g_array_index(self->order, uint32_t, position));
+}
+
+// Hand a finished scan's records and order to the model
+// - The model takes its own references, the whole change is one splice
+
+void dup_model_set (DupModel *self, GArray *recs, GArray *order)
+{
+	uint32_t cnt = self->order->len;
+	g_array_ref(recs);
+	g_array_ref(order);
+	g_array_unref(self->recs);
+	g_array_unref(self->order);
+	self->recs = recs;
+	self->order = order;
+	g_list_model_items_changed(G_LIST_MODEL(self), 0, cnt, order->len);
+}
+
+// Compare the records two positions point at
+
+int cmp_order (const void *a, const void *b, gpointer data)
+{
+	model_sort *sp = data;
+	return sp->cmp(&g_array_index(sp->recs, dup_rec, *(const uint32_t *) a),
+		       &g_array_index(sp->recs, dup_rec, *(const uint32_t *) b), sp->data);
+}
+
+// Sort the model, only the order moves
+// - The compare function gets two records and the data
+
+void dup_model_sort (DupModel *self, GCompareDataFunc cmp, gpointer data)
+{
+	model_sort sort = { self->recs, cmp, data };
+	g_qsort_with_data(self->order->data, self->order->len, sizeof(uint32_t), cmp_order, &sort);
+	g_list_model_items_changed(G_LIST_MODEL(self), 0, self->order->len, self->order->len);
+}
+
+// Keep only the positions whose record passes a test, in the same order
+
+void dup_model_keep (DupModel *self, gboolean (*keep)(dup_rec *, gpointer), gpointer data)
+{
+	uint32_t cnt = self->order->len;
+	uint32_t kept = 0;
+	for (uint32_t i = 0; i < cnt; i++) {
+		uint32_t rec = g_array_index(self->order, uint32_t, i);
+		if (keep(&g_array_index(self->recs, dup_rec, rec), data)) g_array_index(self->order, uint32_t, kept++) = rec;
+	}
+	g_array_set_size(self->order, kept);
+	g_list_model_items_changed(G_LIST_MODEL(self), 0, cnt, kept);
+}
+
+// Make the order for a set of records with no model involved, so a scan thread can do it
+// - Keep the wanted records, then sort the kept order once
+
+GArray *dup_order_new (GArray *recs, gboolean (*keep)(dup_rec *, gpointer), GCompareDataFunc cmp, gpointer data)
+{
+	GArray *order = g_array_sized_new(FALSE, FALSE, sizeof(uint32_t), recs->len);
+	for (uint32_t rec = 0; rec < recs->len; rec++) {
+		if (!keep || keep(&g_array_index(recs, dup_rec, rec), data)) g_array_append_val(order, rec);
+	}
+	model_sort sort = { recs, cmp, data };
+	g_qsort_with_data(order->data, order->len, sizeof(uint32_t), cmp_order, &sort);
+	return order;
+}
+
+// Make one model show the same records in the same order as another
+
+void dup_model_copy (DupModel *src, DupModel *dst)
+{
+	uint32_t cnt = dst->order->len;
+	GArray *recs = g_array_ref(src->recs);
+	g_array_unref(dst->recs);
+	dst->recs = recs;
+	g_array_set_size(dst->order, 0);
+	g_array_append_vals(dst->order, src->order->data, src->order->len);
+	g_list_model_items_changed(G_LIST_MODEL(dst), 0, cnt, dst->order->len);
+}
+
+// Drop all positions, the records stay for any model sharing them
+
+void dup_model_remove_all (DupModel *self)
+{
+	uint32_t cnt = self->order->len;
+	g_array_set_size(self->order, 0);
+	g_list_model_items_changed(G_LIST_MODEL(self), 0, cnt, 0);
+}
@@ -0,0 +1,33 @@
+// This file, dup-model.h, is a part of the Dedupe Entries program.
+// 
+// Copyright (C) 2025  David Hugh
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https:www.gnu.org/licenses/>.
+
+#ifndef dup_model_h
+#define dup_model_h
+
+DupItem *dup_item_new (GArray *, uint32_t);
+dup_rec *dup_item_rec (DupItem *);
+DupModel *dup_model_new (GArray *);
+uint32_t dup_model_n (DupModel *);
+dup_rec *dup_model_rec (DupModel *, uint32_t);
+void dup_model_set (DupModel *, GArray *, GArray *);
+void dup_model_sort (DupModel *, GCompareDataFunc, gpointer);
+void dup_model_keep (DupModel *, gboolean (*)(dup_rec *, gpointer), gpointer);
+GArray *dup_order_new (GArray *, gboolean (*)(dup_rec *, gpointer), GCompareDataFunc, gpointer);
+void dup_model_copy (DupModel *, DupModel *);
+void dup_model_remove_all (DupModel *);
+
+#endif
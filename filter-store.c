@@ -16,6 +16,7 @@
 // along with this program.  If not, see <https:www.gnu.org/licenses/>.
 
 #include "main.h"
+#include "dup-model.h"
 #include "lib.h"
 #include "filter-store.h"
 
@@ -30,30 +31,23 @@ void set_sensitivity_clear_button (filter_entry *ep)
 		gtk_widget_set_sensitive(ep->clear_btn, FALSE);
 }
 
-void shallow_copy_store (GListStore *src, GListStore *dst)
-{
-	uint32_t cnt = g_list_model_get_n_items(G_LIST_MODEL(src));
-	for (uint32_t i = 0; i < cnt; i++) {
-		DupItem *item = g_list_model_get_item(G_LIST_MODEL(src), i);
-		g_list_store_append(G_LIST_STORE(dst), item);
-		g_object_unref(item);
-	}
-}
-
 // Check if the filter text in result
 // - Return based on if a match and if a match is sought
 
-gboolean subres (DupItem *item, user_data *udp)
+gboolean subres (dup_rec *item, user_data *udp)
 {
+	char buff[STR_RESULT] = { 0x00 };
+	const char *result = item_result_text(item, buff, sizeof(buff));
+
 	// False if not sought and filter text is in result
 	if (udp->fep->res_n) {
-		if (strstr(item->result, udp->fep->res_ebt))
+		if (strstr(result, udp->fep->res_ebt))
 			return FALSE;
 		else
 			return TRUE;
 	}
 	else {
-		if (strstr(item->result, udp->fep->res_ebt))
+		if (strstr(result, udp->fep->res_ebt))
 			return TRUE;
 		else
 			return FALSE;
@@ -63,17 +57,20 @@ gboolean subres (DupItem *item, user_data *udp)
 // Check if the filter text in name
 // - Return based on if a match and if a match is sought
 
-gboolean subname (DupItem *item, user_data *udp)
+gboolean subname (dup_rec *item, user_data *udp)
 {
+	char path[STR_PATH] = { 0x00 };
+	const char *name = item_path(item, udp, path);
+
 	// False if not sought and filter text is in name
 	if (udp->fep->name_n) {
-		if (strstr(item->name, udp->fep->name_ebt))
+		if (strstr(name, udp->fep->name_ebt))
 			return FALSE;
 		else
 			return TRUE;
 	}
 	else {
-		if (strstr(item->name, udp->fep->name_ebt))
+		if (strstr(name, udp->fep->name_ebt))
 			return TRUE;
 		else
 			return FALSE;
@@ -84,7 +81,7 @@ gboolean subname (DupItem *item, user_data *udp)
 // - For the match table, treat the combination of sought and match as one factor
 // - And/or logic,  result match yes/no, name match yes/no; 2^3 (8)possibilities
 
-gboolean filter_match (DupItem *item, user_data *udp)
+gboolean filter_match (dup_rec *item, user_data *udp)
 {
 	// Logic for and/or, result yes/no, name yes/no
 	gboolean state = (udp->fep->and && subres(item, udp) && subname(item, udp) ? TRUE : FALSE) ||	// T T T = T
@@ -100,19 +97,12 @@ gboolean filter_match (DupItem *item, user_data *udp)
 }
 
 // Build the filtered list store
-// - Remove all items from the new list store
+// - Start from the current positions and keep those that match, the records are shared
 
-void build_filtered_store(GListStore *current, GListStore *new, user_data *udp)
+void build_filtered_store(DupModel *current, DupModel *new, user_data *udp)
 {
-	// Build the list store based on filter
-	uint32_t cnt = g_list_model_get_n_items(G_LIST_MODEL(current));
-	for (uint32_t i = 0; i < cnt; i++) {
-		DupItem *item = g_list_model_get_item(G_LIST_MODEL(current), i);
-		if (filter_match(item, udp)) {
-			g_list_store_append(new,item);
-		}	
-		g_object_unref(item);
-	}
+	dup_model_copy(current, new);
+	dup_model_keep(new, (gboolean (*)(dup_rec *, gpointer)) filter_match, udp);
 }
 
 
@@ -129,12 +119,11 @@ void apply_filters_cb (GtkWidget *self, user_data *udp)
 
 	// If first filter
 	if (!udp->org_list_store) { 
-		udp->org_list_store = g_list_store_new(G_TYPE_OBJECT);
-		udp->filtered_list_store = g_list_store_new(G_TYPE_OBJECT);
-		shallow_copy_store(udp->list_store, udp->org_list_store);
-		shallow_copy_store(udp->list_store, udp->filtered_list_store);
+		udp->org_list_store = dup_model_new(NULL);
+		udp->filtered_list_store = dup_model_new(NULL);
+		dup_model_copy(udp->list_store, udp->org_list_store);
+		dup_model_copy(udp->list_store, udp->filtered_list_store);
 	}
-	g_list_store_remove_all(udp->list_store);	
 	build_filtered_store(udp->filtered_list_store, udp->list_store, udp);
 }
 
@@ -214,12 +203,11 @@ void initialize_filter (user_data *udp)
 
 	// Copy the saved store to list store if there
 	if (udp->org_list_store) {
-		g_list_store_remove_all(udp->list_store);
-		shallow_copy_store(udp->org_list_store, udp->list_store);
+		dup_model_copy(udp->org_list_store, udp->list_store);
 
 		// Now clear the saved store
-		g_list_store_remove_all(udp->org_list_store);
-		g_list_store_remove_all(udp->filtered_list_store);
+		dup_model_remove_all(udp->org_list_store);
+		dup_model_remove_all(udp->filtered_list_store);
 		g_object_unref(udp->org_list_store);
 		g_object_unref(udp->filtered_list_store);
 		udp->org_list_store = NULL;
@@ -23,6 +23,6 @@ void get_filters_cb (GtkWidget *, user_data *);
 void clear_filters_cb (GtkWidget *, user_data *);
 
 // Forward declarations
-gboolean filter_match (DupItem *, user_data *);
+gboolean filter_match (dup_rec *, user_data *);
 
 #endif
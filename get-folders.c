@@ -106,6 +106,8 @@ void select_multiple_cb (GObject *source, GAsyncResult *result, user_data *udp)
 
 void get_folders_cb (GtkWidget *self, user_data *udp)
 {
+	if (udp->scan) return; // One scan at a time, it reads the folders
+
 	// See if need to allocate folder memory
 	if (!udp->fdpp) udp->fdpp = g_malloc0 (MAX_FOLDERS * sizeof(char *)); // Allocate folder memory
 
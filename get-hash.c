@@ -16,130 +16,73 @@
 // along with this program.  If not, see <https:www.gnu.org/licenses/>.
 
 #include "main.h"
-#include "lib.h"
+#include "hash-engine.h"
+#include "read-pipe.h"
 #include "get-hash.h"
 
-// Setup the progress bar
-// - Show the percentage of the file processed basename being worked
+// Setup the per thread hashing state
+// - Read pipe and its digest states are reused for every job the worker runs
 
-void do_progress_bar (GtkProgressBar *progress_bar, char *percent, const char *name)
+void hash_worker_init (hash_worker *wp, int *cancel, scan_progress *progress, int algo, gboolean drop_cache)
 {
-	char progress[128] = { 0x00 }; // Buffer for progress bar text
-	snprintf(progress, sizeof(progress) - 1, "Processed %s %% of file %s", percent, name);
-	gtk_progress_bar_set_text(progress_bar, progress);
-	do_pending(); // Let progress bar update
+	wp->pipe = read_pipe_new(algo, drop_cache);
+	wp->cancel = cancel;
+	wp->progress = progress;
 }
 
-// Get the sha256 hash of a file
-// - Store into the item hash field as an ascii string of hex digits
-// - Update the progress
-// - Return 0 if mem allocation error, otherwise return 1
+// Free up the per thread hashing state
 
-int getsha256 (DupItem *item, user_data *udp)
+void hash_worker_clear (hash_worker *wp)
 {
+	read_pipe_free(wp->pipe);
+}
 
-	unsigned char ub_hash[EVP_MAX_MD_SIZE] = { 0x00 }; // Will hold hash
-	char c_hash[STR_HASH] = { 0x00 }; // Will hold hash char representation in hex
-
-	// Setup file to read 
-	GFile *file = g_file_new_for_path(item->name);
+// Find the byte range a job reads
+// - A full hash reads the whole file, a tree leaf its own TREE_LEAF slice
+// - A partial stage reads one sample block from the head, tail or middle
 
-	// Setup input stream
-	GFileInputStream *in = g_file_read(file, NULL, NULL);
-	if (!in) {
-		g_object_set(item, "result", "Error: file read failure", "hash", "", NULL);
-		g_object_unref(file);
-		return 1;
+void job_range (hash_job *jp, uint64_t *start, uint64_t *len)
+{
+	if (jp->tree) {
+		*start = jp->offset;
+		*len = MIN(TREE_LEAF, jp->size - jp->offset);
+		return;
 	}
 
-	// Get buffer to read from file
-	unsigned char *read_buff = g_malloc0(READ_BUFF);
-	if (!read_buff) {
-		g_object_set(item, "result", "Error: read buffer allocation failure", NULL);
-		g_object_unref(file);
-		g_input_stream_close(G_INPUT_STREAM(in), NULL, NULL);
-		g_object_unref(in);
-		return 0;
+	*start = 0;
+	*len = jp->size;
+	if (jp->stage == PS_N) return;
+
+	*len = MIN(PARTIAL_BUFF, jp->size);
+	switch (jp->stage) {
+	case PS_TAIL:
+		*start = jp->size - *len;
+		break;
+	case PS_MIDDLE:
+		*start = (jp->size / 2) - (*len / 2);
+		break;
+	default:
+		break;
 	}
+}
 
-	// Get the digest type and initial context
-	const EVP_MD *md = EVP_get_digestbyname("SHA256"); //Setup digest type
-	EVP_MD_CTX *mdctx = EVP_MD_CTX_new(); // Create new context
-	EVP_DigestInit_ex(mdctx, md, NULL);
-
-	// Initial read seeding the while
-	int read = 0;
-	read = g_input_stream_read(G_INPUT_STREAM(in), read_buff, READ_BUFF, NULL, NULL);
-	if (read == -1) {
-		g_object_set(item, "result", "Error: seed read failure", "hash", "", NULL);
-		g_object_unref(file);
-		g_input_stream_close(G_INPUT_STREAM(in), NULL, NULL);
-		g_object_unref(in);
-		return 1;
-	}
-	float all_read = read;
-	char percent_read[7]; // 3 digit number plus '.' plus 2 digit fraction  plus null
-
-	// Loop to read into buffer, update hash and progress bar
-	while (read > 0) {
-
-		if (udp->cancel_request == TRUE) {
-			g_object_set(item, "result", "Error: Hash Canceled", "hash", "", NULL);
-			g_object_unref(file);
-			EVP_MD_CTX_free(mdctx);
-			g_input_stream_close(G_INPUT_STREAM(in), NULL, NULL);
-			g_object_unref(in);
-			g_free(read_buff);
-			return 0;
-
-		}
-
-		// Update hash
-		if (!EVP_DigestUpdate(mdctx, read_buff, read)) {
-			g_object_set(item, "result", "Error: Digest update issue", "hash", "", NULL);
-			g_object_unref(file);
-			EVP_MD_CTX_free(mdctx);
-			g_input_stream_close(G_INPUT_STREAM(in), NULL, NULL);
-			g_object_unref(in);
-			g_free(read_buff);
-			return 1;
-		}
-
-		// Update progress bar
-		snprintf(percent_read, sizeof(percent_read), "%3.2f", (float)all_read / strtol(item->file_size, NULL, 10) * 100.0);
-		do_progress_bar((GtkProgressBar *) udp->progress_bar, percent_read, basename((char *)item->name)); // Show progress bar
-
-		// Fill read buffer from file
-		read = g_input_stream_read(G_INPUT_STREAM(in), read_buff, READ_BUFF, NULL, NULL);
-		all_read += read;
-
-	} // End read while
-
-	// Get the hash into the hash buffer
-	uint32_t md_len = 0;
-	if (!EVP_DigestFinal_ex(mdctx, ub_hash, &md_len)) {
-		g_object_set(item, "result", "Error: Digest final issue", "hash", "", NULL);
-		g_object_unref(file);
-		g_input_stream_close(G_INPUT_STREAM(in), NULL, NULL);
-		g_object_unref(in);
-		return 1;
-	}
+// Start a job's digest
+// - A partial stage chains onto the key from prior stages, so a key match means every sample so far matched
+// - Return 0 if the digest could not be setup (error stored in job), otherwise return 1
 
-	// Make unsigned byte hash into str
-	char *chp = c_hash;
-	for (int i = 0; i < md_len; i++) {
-		snprintf((char *)chp, sizeof(c_hash), "%02x", ub_hash[i]); // Convert to hex and store
-		chp += 2;
+int job_digest_init (hash_job *jp, hash_ctx *hp)
+{
+	if (!hash_ctx_init(hp) ||
+	    (jp->stage != PS_N && !hash_ctx_update(hp, jp->key, SHA256_DIGEST_LENGTH))) {
+		jp->error = "Error: Digest init issue";
+		return 0;
 	}
+	return 1;
+}
 
-	// Set the hash into the item
-	g_object_set(item, "hash", c_hash, NULL);
+// Finish a job's digest into its key
 
-	// Cleanup
-	g_object_unref(file);
-	EVP_MD_CTX_free(mdctx);
-	g_input_stream_close(G_INPUT_STREAM(in), NULL, NULL);
-	g_object_unref(in);
-	g_free(read_buff);
-	return 1;
+void job_digest_final (hash_job *jp, hash_ctx *hp)
+{
+	if (!hash_ctx_final(hp, jp->key, &jp->md_len)) jp->error = "Error: Digest final issue";
 }
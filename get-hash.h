@@ -18,6 +18,10 @@
 #ifndef get_hash_h
 #define get_hash_h
 
-int getsha256 (DupItem *, user_data *);
+void hash_worker_init (hash_worker *, int *, scan_progress *, int, gboolean);
+void hash_worker_clear (hash_worker *);
+void job_range (hash_job *, uint64_t *, uint64_t *);
+int job_digest_init (hash_job *, hash_ctx *);
+void job_digest_final (hash_job *, hash_ctx *);
 
 #endif
@@ -16,101 +16,109 @@
 // along with this program.  If not, see <https:www.gnu.org/licenses/>.
 
 #include "main.h"
+#include "hash-engine.h"
 #include "get-results.h"
 
-// Comparison function to sort list store by hash
-int cmp_function (const void *a, const void *b)
+// Hash a group key, the digest is already well mixed so its first bytes do
+// - Size is folded in since the key is size and digest
+
+guint group_key_hash (const void *key)
+{
+	dup_rec const *item = key;
+	uint32_t head = 0;
+	memcpy(&head, item->digest, sizeof(head));
+	return head ^ (guint) item->size ^ (guint) (item->size >> 32);
+}
+
+// Items with equal size and digest belong to the same group
+
+gboolean group_key_equal (const void *a, const void *b)
 {
-	DupItem const *a_item = a;
-	DupItem const *b_item = b;
-	return(strcmp(a_item->hash, b_item->hash)); // Compare hash
+	dup_rec const *a_item = a;
+	dup_rec const *b_item = b;
+	return a_item->size == b_item->size && !memcmp(a_item->digest, b_item->digest, SHA256_DIGEST_LENGTH);
 }
 
-// Get group designation into the result field of the item
-// - Field could have been initialed with error or directory prior to call, othewise pointer is 0
+// Get group designation into the result of the item
+// - Result could have been set to error, directory, empty, link or unique prior to call, othewise kind is RK_NONE
+// - One pass over all the roots files a hashed item under its size and digest, a second marks the groups
+// - Group numbers follow the order a group first gains a second member, no sort needed
+// - Runs on the scan thread, the totals are shown once the scan is done
 
 int get_results (user_data *udp)
 {
-	// Use quick sort - sort by hash to enable finding dup groups
-	g_list_store_sort(udp->list_store, (GCompareDataFunc) cmp_function, NULL);
-
-	// String work buff
-	char buff[100] = { 0x00 };
-
-	// Loop through sorted file to get unqiue groups assigned to each file based on hash
-	char cghash[65] = "a hash"; // Will store current group hash while looping
-	memset(&cghash, 0x00, sizeof(cghash));
-	uint32_t group = 0; // Will serve as the group identifier
-	uint32_t i = 0; // Loop counter
-	uint32_t cnt = g_list_model_get_n_items(G_LIST_MODEL(udp->list_store));
-
-	// Edge case of 1 entry
-	if (cnt == 1) {
-		DupItem *item = g_list_model_get_item((GListModel *) udp->list_store, 0);
-		if (item->result != 0x00) { // Skip if already initialed
-			g_object_unref(item);
-			return 1;
+	GArray *recs = udp->scan->recs;
+	uint32_t cnt = recs->len;
+	GHashTable *keys = g_hash_table_new(group_key_hash, group_key_equal); // First member to tally position + 1
+	GArray *tallies = g_array_new(FALSE, TRUE, sizeof(group_tally));
+	GArray *slots = g_array_sized_new(FALSE, FALSE, sizeof(uint32_t), cnt); // Tally position per item
+	g_array_set_size(slots, cnt);
+
+	memset(&udp->totals, 0x00, sizeof(udp->totals));
+	g_atomic_int_set(&udp->scan->progress.phase, SP_GROUP);
+
+	// File each hashed item under its key
+	for (uint32_t i = 0; i < cnt; i++) {
+		if (g_atomic_int_get(&udp->cancel_request)) break; // Stop processing if cancel requested
+
+		dup_rec *item = &g_array_index(recs, dup_rec, i);
+		if (item->kind != RK_NONE) continue; // Result already known
+
+		uint32_t slot = GPOINTER_TO_UINT(g_hash_table_lookup(keys, item));
+		if (!slot) { // First of its key
+			group_tally tally = { 0, 0, 0, item->size };
+			g_array_append_val(tallies, tally);
+			slot = tallies->len;
+			g_hash_table_insert(keys, item, GUINT_TO_POINTER(slot));
 		}
-		g_object_set(item, "result", STR_UNI, NULL);
-		g_object_unref(item);
-		return 1;
+		group_tally *tp = &g_array_index(tallies, group_tally, slot - 1);
+		if (++tp->files == 2) tp->group = ++udp->totals.groups; // Found a group
+		if (item->nlink <= 1) tp->unlinked++;
+		g_array_index(slots, uint32_t, i) = slot;
 	}
 
-	// Main loop to determine groups
-	while ((i + 1) < cnt) { // Since look ahead to determine group, last struct handled outside loop
-
-		if (udp->cancel_request == TRUE) return 0; // Stop processing if cancel requested
-
-		DupItem *item = g_list_model_get_item((GListModel *) udp->list_store, i);
-		DupItem *next_item = g_list_model_get_item((GListModel *) udp->list_store, i + 1);
-
-		// Skip if result already initialed
-		if (item->result != 0x00) {
-			i++;
-			g_object_unref(item);
-			g_object_unref(next_item);
-			continue;
-		}
+	// Mark the members, a key with one member is unique
+	for (uint32_t i = 0; i < cnt && !g_atomic_int_get(&udp->cancel_request); i++) {
+		dup_rec *item = &g_array_index(recs, dup_rec, i);
+		if (item->kind != RK_NONE) continue;
+		group_tally *tp = &g_array_index(tallies, group_tally, g_array_index(slots, uint32_t, i) - 1);
+		item->kind = tp->group ? RK_GROUP : RK_UNIQUE;
+		item->group = tp->group;
+	}
 
-		// See if current item equal to saved current group hash        
-		if (!strcmp((const char *)cghash, item->hash)) { // True if not equal to current group 
-			snprintf(buff, sizeof(buff), "%07d", group);
-			g_object_set(item, "result", buff, NULL);
-		}
-		else { // Current hash = previous hash
-			if (!strcmp(item->hash, next_item->hash)) { // See if next hash =, if so means a group
-				group++; // Found a group
-				snprintf(buff, sizeof(buff), "%07d", group);
-				g_object_set(item, "result", buff, NULL);
-				strncpy(cghash, item->hash, sizeof(cghash));
-			}
-			else {
-				g_object_set(item, "result", STR_UNI, NULL);
-			}
-		}
-		i++;
-		g_object_unref(item);
-		g_object_unref(next_item);
+	// Total the group sizes, every member but one could go
+	// - Only members without other hardlinks free space, as when trashing, and one of them is counted as kept
+	for (uint32_t i = 0; i < tallies->len; i++) {
+		group_tally *tp = &g_array_index(tallies, group_tally, i);
+		if (!tp->group) continue;
+		udp->totals.files += tp->files;
+		if (tp->unlinked) udp->totals.reclaim += tp->size * (tp->unlinked - 1);
+		if (tp->files > udp->totals.largest) udp->totals.largest = tp->files;
 	}
 
-	// Handle last file struct outside of loop
-	DupItem *item = g_list_model_get_item((GListModel *) udp->list_store, i);
+	g_hash_table_destroy(keys);
+	g_array_unref(tallies);
+	g_array_unref(slots);
 
-	// First see if result already there
-	if (item->result != 0x00) { // Skip if a directory or an error
-		g_object_unref(item);
-		return 1;
-	}
+	return !g_atomic_int_get(&udp->cancel_request);
+}
 
-	// Create a result
-	if (!strcmp((const char *)cghash, item->hash)) { // False if equal 
-		snprintf(buff, sizeof(buff), "%07d", group);
-		g_object_set(item, "result", buff, NULL);
-	}
-	else {
-		g_object_set(item, "result", STR_UNI, NULL);
-	}
+// Show the group totals in the main window title
+// - Hash engine, groups, files in groups, the largest group and what trashing all but one of each would free
 
-	g_object_unref(item);
-	return 1;
+void show_group_totals (user_data *udp)
+{
+	char title[STR_TITLE] = { 0x00 };
+	const char *method = udp->totals.verified ? "Byte for byte" : hash_algo_name(udp->totals.algo);
+	const char *cache = udp->totals.drop_cache ? " (page cache dropped)" : "";
+	if (!udp->totals.groups) {
+		snprintf(title, sizeof(title), "Dedupe Entries - %s%s - No duplicates", method, cache);
+		gtk_window_set_title(GTK_WINDOW(udp->main_window), title);
+		return;
+	}
+	char *reclaim = g_format_size(udp->totals.reclaim);
+	snprintf(title, sizeof(title), "Dedupe Entries - %s%s - %u groups - %u files - largest %u - %s reclaimable",
+		 method, cache, udp->totals.groups, udp->totals.files, udp->totals.largest, reclaim);
+	g_free(reclaim);
+	gtk_window_set_title(GTK_WINDOW(udp->main_window), title);
 }
@@ -17,6 +17,9 @@
 #ifndef get_results_h
 #define get_results_h
 
+guint group_key_hash (const void *);
+gboolean group_key_equal (const void *, const void *);
 int get_results(user_data *);
+void show_group_totals (user_data *);
 
 #endif
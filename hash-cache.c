@@ -0,0 +1,185 @@
+// This file, hash-cache.c, is a part of the Dedupe Entries program.
+// 
+// Copyright (C) 2025  David Hugh
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https:www.gnu.org/licenses/>.
+
+#include <sys/mman.h>
+#include <sys/file.h>
+#include "main.h"
+#include "hash-engine.h"
+#include "hash-cache.h"
+
+// Length of the mapping for a slot count
+
+size_t cache_map_len (uint64_t cap)
+{
+	return sizeof(cache_head) + cap * sizeof(cache_rec);
+}
+
+// Size the file for a slot count and map it
+// - Return 0 on failure, otherwise return 1
+
+int cache_map (hash_cache *hcp, uint64_t cap)
+{
+	size_t len = cache_map_len(cap);
+	if (ftruncate(hcp->fd, len) == -1) return 0;
+
+	void *map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, hcp->fd, 0);
+	if (map == MAP_FAILED) return 0;
+
+	hcp->head = map;
+	hcp->recs = (cache_rec *) (hcp->head + 1);
+	hcp->map_len = len;
+	return 1;
+}
+
+// Starting slot for a file, slots are keyed on device and inode so a changed file reuses its slot
+
+uint64_t cache_slot (hash_cache *hcp, uint64_t dev, uint64_t ino)
+{
+	uint64_t h = (ino * 0x9e3779b97f4a7c15ULL) ^ (dev * 0xc2b2ae3d27d4eb4fULL);
+	return (h ^ (h >> 29)) & (hcp->head->cap - 1);
+}
+
+// Find the slot for a file, either its own or the free one it would take
+
+cache_rec *cache_find (hash_cache *hcp, uint64_t dev, uint64_t ino)
+{
+	uint64_t mask = hcp->head->cap - 1;
+	uint64_t i = cache_slot(hcp, dev, ino);
+	while (hcp->recs[i].size && (hcp->recs[i].dev != dev || hcp->recs[i].ino != ino)) i = (i + 1) & mask;
+	return &hcp->recs[i];
+}
+
+// Double the slots and rehash, keeps the load low so probes stay short
+// - Return 0 on failure, otherwise return 1
+
+int cache_grow (hash_cache *hcp)
+{
+	uint64_t old_cap = hcp->head->cap;
+	uint64_t count = hcp->head->count;
+	cache_rec *old = g_memdup2(hcp->recs, old_cap * sizeof(cache_rec));
+
+	munmap(hcp->head, hcp->map_len);
+	if (!cache_map(hcp, old_cap * 2)) {
+		g_free(old);
+		hcp->head = NULL;
+		return 0;
+	}
+	memset(hcp->recs, 0x00, old_cap * 2 * sizeof(cache_rec));
+	hcp->head->cap = old_cap * 2;
+	hcp->head->count = count;
+
+	for (uint64_t i = 0; i < old_cap; i++) {
+		if (old[i].size) *cache_find(hcp, old[i].dev, old[i].ino) = old[i];
+	}
+	g_free(old);
+	return 1;
+}
+
+// Open the hash cache in the home cache folder, creating it if needed
+// - Each hash engine has its own cache file, so switching engines never mixes digests
+// - Locked so a second instance runs without the cache rather than waiting
+// - A file that is not a cache, is damaged, or is from another engine is started over
+// - Return NULL if the cache can't be used, scanning goes on without it
+
+hash_cache *hash_cache_open (int algo)
+{
+	char name[STR_PATH] = { 0x00 };
+	char *suffix = algo == HA_SHA256 ? g_strdup("") : g_ascii_strdown(hash_algo_name(algo), -1); // SHA256 keeps the original name
+	snprintf(name, sizeof(name), "%s%s%s%s%s", g_get_home_dir(), STR_CACHE, *suffix ? "-" : "", suffix, STR_CACHE_EXT);
+	g_free(suffix);
+
+	char *dir = g_path_get_dirname(name);
+	g_mkdir_with_parents(dir, 0700);
+	g_free(dir);
+
+	hash_cache *hcp = g_malloc0(sizeof(hash_cache));
+	hcp->fd = open(name, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+	if (hcp->fd == -1) {
+		g_free(hcp);
+		return NULL;
+	}
+	if (flock(hcp->fd, LOCK_EX | LOCK_NB) == -1) {
+		close(hcp->fd);
+		g_free(hcp);
+		return NULL;
+	}
+
+	// Check the header fits the file before trusting it
+	struct stat attr;
+	cache_head head = { 0x00 };
+	gboolean good = (fstat(hcp->fd, &attr) == 0 && pread(hcp->fd, &head, sizeof(head), 0) == sizeof(head) &&
+			 head.magic == CACHE_MAGIC && head.algo == (uint64_t) algo && head.cap && !(head.cap & (head.cap - 1)) &&
+			 head.count < head.cap && (uint64_t) attr.st_size == cache_map_len(head.cap));
+
+	uint64_t cap = good ? head.cap : CACHE_INIT_CAP;
+	if (!good && ftruncate(hcp->fd, 0) == -1) good = FALSE; // Drop any old content so the new map starts zeroed
+	if (!cache_map(hcp, cap)) {
+		close(hcp->fd);
+		g_free(hcp);
+		return NULL;
+	}
+	if (!good) {
+		hcp->head->magic = CACHE_MAGIC;
+		hcp->head->cap = cap;
+		hcp->head->count = 0;
+		hcp->head->algo = algo;
+	}
+	return hcp;
+}
+
+// Look up a file's full digest
+// - Only a hit if size and nanosecond mtime are also unchanged
+// - Return TRUE and fill digest on a hit
+
+gboolean hash_cache_get (hash_cache *hcp, dup_rec *item, unsigned char *digest)
+{
+	if (!hcp || !hcp->head) return FALSE;
+
+	cache_rec *rp = cache_find(hcp, item->dev, item->ino);
+	if (!rp->size || rp->size != item->size || rp->mtime_ns != item->mtime_ns) return FALSE;
+	memcpy(digest, rp->digest, SHA256_DIGEST_LENGTH);
+	return TRUE;
+}
+
+// Store a file's full digest, replacing any older digest for the same file
+
+void hash_cache_put (hash_cache *hcp, dup_rec *item, const unsigned char *digest)
+{
+	if (!hcp || !hcp->head || !item->size) return;
+	if ((hcp->head->count + 1) * 4 > hcp->head->cap * 3 && !cache_grow(hcp)) return;
+
+	cache_rec *rp = cache_find(hcp, item->dev, item->ino);
+	if (!rp->size) hcp->head->count++;
+
+	// Size goes in last, so a slot is never seen in use with half its fields
+	rp->size = 0;
+	rp->dev = item->dev;
+	rp->ino = item->ino;
+	rp->mtime_ns = item->mtime_ns;
+	memcpy(rp->digest, digest, SHA256_DIGEST_LENGTH);
+	rp->size = item->size;
+}
+
+// Unmap, unlock and close the hash cache
+
+void hash_cache_close (hash_cache *hcp)
+{
+	if (!hcp) return;
+	if (hcp->head) munmap(hcp->head, hcp->map_len);
+	close(hcp->fd); // Also drops the lock
+	g_free(hcp);
+}
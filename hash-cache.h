@@ -0,0 +1,26 @@
+// This file, hash-cache.h, is a part of the Dedupe Entries program.
+// 
+// Copyright (C) 2025  David Hugh
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https:www.gnu.org/licenses/>.
+
+#ifndef hash_cache_h
+#define hash_cache_h
+
+hash_cache *hash_cache_open (int);
+gboolean hash_cache_get (hash_cache *, dup_rec *, unsigned char *);
+void hash_cache_put (hash_cache *, dup_rec *, const unsigned char *);
+void hash_cache_close (hash_cache *);
+
+#endif
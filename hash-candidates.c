@@ -0,0 +1,356 @@
+// This file, hash-candidates.c, is a part of the Dedupe Entries program.
+// 
+// Copyright (C) 2025  David Hugh
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https:www.gnu.org/licenses/>.
+
+#include "main.h"
+#include "lib.h"
+#include "hash-engine.h"
+#include "get-hash.h"
+#include "hash-pool.h"
+#include "hash-cache.h"
+#include "hash-candidates.h"
+
+// Comparison function to sort jobs by size and then by partial key
+// - Key is all zero until the first partial stage
+
+int cmp_candidate (const void *a, const void *b)
+{
+	const hash_job *job_a = a;
+	const hash_job *job_b = b;
+	if (job_a->size < job_b->size) return -1;
+	else if (job_a->size > job_b->size) return 1;
+	else return memcmp(job_a->key, job_b->key, SHA256_DIGEST_LENGTH);
+}
+
+// Comparison function to sort jobs by size, then file identity, then walk order
+
+int cmp_file_id (const void *a, const void *b)
+{
+	const hash_job *job_a = a;
+	const hash_job *job_b = b;
+	if (job_a->size != job_b->size) return (job_a->size > job_b->size) - (job_a->size < job_b->size);
+	if (job_a->item->dev != job_b->item->dev) return (job_a->item->dev > job_b->item->dev) - (job_a->item->dev < job_b->item->dev);
+	if (job_a->item->ino != job_b->item->ino) return (job_a->item->ino > job_b->item->ino) - (job_a->item->ino < job_b->item->ino);
+	return (job_a->item > job_b->item) - (job_a->item < job_b->item); // Records are in walk order
+}
+
+// Drop the candidates that are a file already seen, so a file is never grouped with itself
+// - A copy of one file always has the same size, so only the candidates need checking
+// - With other hardlinks it is another link to the first one walked, never read or counted as a duplicate
+// - With one link it is the same entry reached again through overlapping roots or a bind mount, and is not shown
+// - Survivors are compacted to the front, return the new count
+
+uint32_t prune_repeats (hash_job *jobs, uint32_t n, scan_state *sp)
+{
+	qsort(jobs, n, sizeof(hash_job), cmp_file_id);
+
+	uint32_t kept = 0;
+	for (uint32_t i = 0; i < n; i++) {
+		dup_rec *item = jobs[i].item;
+		dup_rec *prev = kept ? jobs[kept - 1].item : NULL;
+		if (prev && prev->size == item->size && prev->dev == item->dev && prev->ino == item->ino) {
+			if (item->nlink > 1) item->kind = RK_LINK;
+			else {
+				item->kind = RK_REPEAT;
+				sp->repeats++;
+			}
+			continue;
+		}
+		jobs[kept++] = jobs[i];
+	}
+	return kept;
+}
+
+// See if a partial stage is worth running for a file size
+// - Small files are a single read anyway, middle only pays off on large files
+
+gboolean stage_applies (int stage, uint64_t size)
+{
+	if (size <= PARTIAL_MIN) return FALSE;
+	if (stage == PS_MIDDLE && size < PARTIAL_MIDDLE_MIN) return FALSE;
+	return TRUE;
+}
+
+// Sort the candidates and drop any that match no other candidate
+// - A run of one is marked unique and dropped
+// - Survivors are compacted to the front, return the new count
+
+uint32_t prune_singles (hash_job *jobs, uint32_t n)
+{
+	qsort(jobs, n, sizeof(hash_job), cmp_candidate);
+
+	uint32_t kept = 0;
+	uint32_t i = 0;
+	while (i < n) {
+		uint32_t j = i + 1;
+		while (j < n && !cmp_candidate(&jobs[i], &jobs[j])) j++;
+
+		if (j - i == 1) jobs[i].item->kind = RK_UNIQUE;
+		else {
+			for (uint32_t k = i; k < j; k++) jobs[kept++] = jobs[k];
+		}
+		i = j;
+	}
+	return kept;
+}
+
+// Look up the candidates in the hash cache
+// - A size where every file is cached needs no reads, the cached digests stand in as final keys
+// - A size with some files uncached still samples them all, only the full hash is skipped for cached files
+// - Candidates must be sorted by size
+
+void apply_cache (hash_cache *hcp, hash_job *jobs, uint32_t n)
+{
+	for (uint32_t i = 0; i < n; i++) jobs[i].cached = hash_cache_get(hcp, jobs[i].item, jobs[i].digest);
+
+	uint32_t i = 0;
+	while (i < n) {
+		uint32_t j = i;
+		gboolean all = TRUE;
+		while (j < n && jobs[j].size == jobs[i].size) all &= jobs[j++].cached;
+
+		for (uint32_t k = i; all && k < j; k++) {
+			memcpy(jobs[k].key, jobs[k].digest, SHA256_DIGEST_LENGTH);
+			jobs[k].md_len = SHA256_DIGEST_LENGTH;
+			jobs[k].stage = PS_N;
+		}
+		i = j;
+	}
+}
+
+// Count the tree leaves a file's full hash is split into, 0 if it is hashed whole
+
+uint32_t tree_leaves (uint64_t size)
+{
+	if (size < TREE_MIN) return 0;
+	return (size + TREE_LEAF - 1) / TREE_LEAF;
+}
+
+// Queue the tree leaves of a huge file, each one a job any worker can take
+// - Return the new count of leaves
+
+uint32_t queue_leaves (hash_job *jp, hash_job *leaves, uint32_t nl, hash_job **todo, uint32_t *mp)
+{
+	uint32_t cnt = tree_leaves(jp->size);
+	for (uint32_t i = 0; i < cnt; i++) {
+		hash_job *lp = &leaves[nl++];
+		lp->item = jp->item; // A failed leaf puts its error on the file
+		lp->name = jp->name;
+		lp->size = jp->size;
+		lp->stage = PS_N;
+		lp->tree = jp;
+		lp->offset = (uint64_t) i * TREE_LEAF;
+		todo[(*mp)++] = lp;
+	}
+	return nl;
+}
+
+// Make the root digest of each tree hashed file from its leaf digests in file order
+// - The leaf size is hashed first, so the root only ever matches another root made the same way
+// - A failed leaf fails its file, the error is already committed by the leaf
+// - The files never went through the pool, so they are committed here
+
+void tree_roots (hash_job *leaves, uint32_t nl, int algo, scan_progress *pp)
+{
+	hash_ctx *hp = hash_ctx_new(algo);
+	uint64_t leaf = TREE_LEAF;
+
+	uint32_t i = 0;
+	while (i < nl) {
+		hash_job *jp = leaves[i].tree;
+		gboolean good = hash_ctx_init(hp) && hash_ctx_update(hp, &leaf, sizeof(leaf));
+		for (; i < nl && leaves[i].tree == jp; i++) {
+			if (leaves[i].error) jp->error = leaves[i].error;
+			else if (good) good = hash_ctx_update(hp, leaves[i].key, leaves[i].md_len);
+		}
+		g_atomic_int_inc(&pp->files);
+		if (jp->error) continue;
+		if (!good || !hash_ctx_final(hp, jp->key, &jp->md_len)) jp->error = "Error: Digest final issue";
+		commit_job(jp);
+	}
+	hash_ctx_free(hp);
+}
+
+// Run one stage over the candidates through the hash pool, updating the count
+// - Stage PS_N is the full hash, the others are partial samples followed by a prune
+// - A full hash of a huge file is split into tree leaves so all the workers share it, the root is the file's digest
+// - A failed job already has its error committed to the item and is dropped
+// - Full hashes come from the hash cache where known, new ones are saved to it
+// - Return 0 if cancel requested, otherwise return 1
+
+int run_stage (hash_pool *pool, hash_cache *hcp, hash_job *jobs, hash_job **todo, uint32_t *np, int stage, user_data *udp)
+{
+	scan_progress *pp = &udp->scan->progress;
+	uint32_t n = *np;
+	uint32_t m = 0;
+	uint64_t start, len;
+	gsize bytes = 0; // Bytes the stage will read
+	gsize full = 0; // Bytes a later full hash of the survivors would read
+	hash_job *leaves = NULL;
+	uint32_t nl = 0;
+
+	if (stage == PS_N) {
+		for (uint32_t i = 0; i < n; i++) nl += jobs[i].cached ? 0 : tree_leaves(jobs[i].size);
+		leaves = g_malloc0((nl + 1) * sizeof(hash_job));
+		nl = 0;
+	}
+
+	// Queue the jobs the stage applies to
+	for (uint32_t i = 0; i < n; i++) {
+		if (jobs[i].cached && (stage == PS_N || jobs[i].stage == PS_N)) continue; // Digest already known
+		if (stage != PS_N && !jobs[i].cached) full += jobs[i].size;
+		if (stage == PS_N || stage_applies(stage, jobs[i].size)) {
+			jobs[i].stage = stage;
+			job_range(&jobs[i], &start, &len);
+			bytes += len;
+			if (stage == PS_N && tree_leaves(jobs[i].size)) nl = queue_leaves(&jobs[i], leaves, nl, todo, &m);
+			else todo[m++] = &jobs[i];
+		}
+	}
+
+	// Overall progress is bytes read against what this stage and a full hash of every survivor would read
+	// - The survivors' full hash is the worst case, later samples prune it and the plan shrinks
+	g_atomic_pointer_set(&pp->planned, (gsize) g_atomic_pointer_get(&pp->bytes) + bytes + full);
+	g_atomic_int_set(&pp->stage, stage);
+	g_atomic_int_set(&pp->phase, stage == PS_N ? SP_HASH : SP_SAMPLE);
+	int run = hash_pool_run(pool, todo, m, udp);
+	if (run && nl) tree_roots(leaves, nl, udp->scan->algo, pp);
+	g_free(leaves);
+	if (!run) return 0;
+
+	// Drop the failures, commit the cached full hashes and save the new ones
+	uint32_t kept = 0;
+	for (uint32_t i = 0; i < n; i++) {
+		if (jobs[i].error) continue;
+		if (stage == PS_N && jobs[i].cached) {
+			memcpy(jobs[i].key, jobs[i].digest, SHA256_DIGEST_LENGTH);
+			jobs[i].md_len = SHA256_DIGEST_LENGTH;
+			jobs[i].stage = PS_N;
+			commit_job(&jobs[i]);
+		}
+		else if (stage == PS_N) hash_cache_put(hcp, jobs[i].item, jobs[i].key);
+		jobs[kept++] = jobs[i];
+	}
+
+	*np = (stage == PS_N) ? kept : prune_singles(jobs, kept);
+	return 1;
+}
+
+// Verify the surviving candidates byte for byte in place of the full hash
+// - Each run of matching size and samples is one job for a worker, led by its first member
+// - Matching members come back with a shared token as their key, which stands in for the digest when grouping
+// - A member that matched no other is unique, a failed one has its error committed
+// - Nothing goes in the hash cache since no digest was made
+// - Return 0 if cancel requested, otherwise return 1
+
+int run_verify (hash_pool *pool, hash_job *jobs, hash_job **todo, uint32_t n, user_data *udp)
+{
+	scan_progress *pp = &udp->scan->progress;
+	uint32_t m = 0;
+	gsize bytes = 0; // Bytes read if no member differs
+
+	// Queue one job per candidate group, the jobs are still sorted from the last prune
+	uint32_t i = 0;
+	while (i < n) {
+		uint32_t j = i + 1;
+		while (j < n && !cmp_candidate(&jobs[i], &jobs[j])) j++;
+		for (uint32_t k = i; k < j; k++) {
+			jobs[k].stage = PS_N;
+			bytes += jobs[k].size;
+		}
+		jobs[i].members = j - i;
+		todo[m++] = &jobs[i];
+		i = j;
+	}
+
+	g_atomic_pointer_set(&pp->planned, (gsize) g_atomic_pointer_get(&pp->bytes) + bytes);
+	g_atomic_int_set(&pp->phase, SP_VERIFY);
+	if (!hash_pool_run(pool, todo, m, udp)) return 0;
+
+	// Drop the failures, then commit the members that matched another
+	uint32_t kept = 0;
+	for (i = 0; i < n; i++) {
+		jobs[i].members = 0;
+		if (jobs[i].error) commit_job(&jobs[i]);
+		else jobs[kept++] = jobs[i];
+	}
+	kept = prune_singles(jobs, kept);
+	for (i = 0; i < kept; i++) commit_job(&jobs[i]);
+	return 1;
+}
+
+// Hash only the files that could still have a duplicate
+// - Only a file with a size in common can have a duplicate, so a unique size is marked unique unread
+// - Within a size, head, tail and middle samples prune further before any full read
+// - Runs once after all selected folders are traversed so sizes are compared across folders
+// - Files unchanged since an earlier scan take their full hash from the hash cache
+// - In verify mode the sampled survivors are compared byte for byte instead, and the cache is not trusted
+// - Reading and hashing is done by the worker pool, results are committed here on the scan thread
+// - Return 0 if cancel requested, otherwise return 1
+
+int hash_candidates (user_data *udp)
+{
+	int rcode = 1; // Return code, 1 is good, 0 is stop
+	GArray *recs = udp->scan->recs;
+	uint32_t cnt = recs->len;
+	uint32_t n = 0;
+	char path[STR_PATH] = { 0x00 };
+
+	// Jobs are only made for the non-empty files, anything with a result already is a directory, empty, error or link
+	for (uint32_t i = 0; i < cnt; i++) n += (g_array_index(recs, dup_rec, i).kind == RK_NONE);
+	hash_job *jobs = g_malloc0((n + 1) * sizeof(hash_job));
+	n = 0;
+
+	// Collect the non-empty files
+	for (uint32_t i = 0; i < cnt; i++) {
+		dup_rec *item = &g_array_index(recs, dup_rec, i);
+		if (item->kind != RK_NONE) continue;
+		jobs[n].item = item; // Records stay put once the walk is done
+		jobs[n].size = item->size;
+		n++;
+	}
+
+	// Drop files reached twice, then prune on size alone, then on cached digests, then on each partial stage, then full hash whatever still collides
+	hash_cache *hcp = hash_cache_open(udp->scan->algo);
+	n = prune_repeats(jobs, n, udp->scan);
+	n = prune_singles(jobs, n);
+	if (!udp->scan->verify) apply_cache(hcp, jobs, n);
+	n = prune_singles(jobs, n);
+
+	// Only the files that may be read need a full path, all kept in one chunk
+	GStringChunk *paths = g_string_chunk_new(STR_PATH * 64);
+	for (uint32_t i = 0; i < n; i++) jobs[i].name = g_string_chunk_insert(paths, item_path(jobs[i].item, udp, path));
+
+	// Room to queue every file, and the tree leaves of the huge ones
+	uint32_t spare = 0;
+	for (uint32_t i = 0; i < n; i++) spare += tree_leaves(jobs[i].size);
+	hash_job **todo = g_malloc0((n + spare + 1) * sizeof(hash_job *));
+
+	hash_pool *pool = hash_pool_new(&udp->scan->progress, udp->scan->algo, udp->scan->drop_cache);
+	int last = udp->scan->verify ? PS_MIDDLE : PS_N;
+	for (int stage = PS_HEAD; stage <= last && rcode; stage++) {
+		rcode = run_stage(pool, hcp, jobs, todo, &n, stage, udp);
+	}
+	if (rcode && udp->scan->verify) rcode = run_verify(pool, jobs, todo, n, udp);
+	hash_pool_free(pool);
+	hash_cache_close(hcp);
+
+	// Clean up
+	g_string_chunk_free(paths);
+	g_free(todo);
+	g_free(jobs);
+	return rcode;
+}
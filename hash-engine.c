@@ -0,0 +1,157 @@
+// This file, hash-engine.c, is a part of the Dedupe Entries program.
+// 
+// Copyright (C) 2025  David Hugh
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https:www.gnu.org/licenses/>.
+
+#include "main.h"
+#include "hash-engine.h"
+
+// Name of a hash algorithm, shown in the options and with the results
+
+const char *hash_algo_name (int algo)
+{
+	switch (algo) {
+	case HA_BLAKE3:
+		return "BLAKE3";
+	case HA_XXH3:
+		return "XXH3-128";
+	default:
+		return "SHA256";
+	}
+}
+
+// See if an algorithm was built in, SHA256 always is
+
+gboolean hash_algo_built (int algo)
+{
+	switch (algo) {
+#ifdef HAVE_BLAKE3
+	case HA_BLAKE3:
+		return TRUE;
+#endif
+#ifdef HAVE_XXHASH
+	case HA_XXH3:
+		return TRUE;
+#endif
+	case HA_SHA256:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+// Make a digest state for an algorithm, one is reused for every file through a pipe stream
+// - An algorithm that was not built in falls back to SHA256
+
+hash_ctx *hash_ctx_new (int algo)
+{
+	hash_ctx *hp = g_malloc0(sizeof(hash_ctx));
+	hp->algo = hash_algo_built(algo) ? algo : HA_SHA256;
+
+	switch (hp->algo) {
+#ifdef HAVE_XXHASH
+	case HA_XXH3:
+		hp->xxh3 = XXH3_createState();
+		break;
+#endif
+	case HA_SHA256:
+		hp->md = EVP_MD_CTX_new();
+		hp->type = EVP_MD_fetch(NULL, "SHA256", NULL);
+		break;
+	default:
+		break; // BLAKE3 state lives in the struct
+	}
+	return hp;
+}
+
+// Free up a digest state
+
+void hash_ctx_free (hash_ctx *hp)
+{
+	if (hp->md) EVP_MD_CTX_free(hp->md);
+	if (hp->type) EVP_MD_free(hp->type);
+#ifdef HAVE_XXHASH
+	if (hp->xxh3) XXH3_freeState(hp->xxh3);
+#endif
+	g_free(hp);
+}
+
+// Start a digest
+// - Return 0 on failure, otherwise return 1
+
+int hash_ctx_init (hash_ctx *hp)
+{
+	switch (hp->algo) {
+#ifdef HAVE_BLAKE3
+	case HA_BLAKE3:
+		blake3_hasher_init(&hp->blake3);
+		return 1;
+#endif
+#ifdef HAVE_XXHASH
+	case HA_XXH3:
+		return XXH3_128bits_reset(hp->xxh3) == XXH_OK;
+#endif
+	default:
+		return EVP_DigestInit_ex(hp->md, hp->type, NULL);
+	}
+}
+
+// Add data to a digest
+// - Return 0 on failure, otherwise return 1
+
+int hash_ctx_update (hash_ctx *hp, const void *data, size_t len)
+{
+	switch (hp->algo) {
+#ifdef HAVE_BLAKE3
+	case HA_BLAKE3:
+		blake3_hasher_update(&hp->blake3, data, len); // SIMD level is picked by the library at run time
+		return 1;
+#endif
+#ifdef HAVE_XXHASH
+	case HA_XXH3:
+		return XXH3_128bits_update(hp->xxh3, data, len) == XXH_OK;
+#endif
+	default:
+		return EVP_DigestUpdate(hp->md, data, len);
+	}
+}
+
+// Finish a digest into a key
+// - Every key is SHA256_DIGEST_LENGTH bytes, a shorter digest is zero filled so keys compare the same way
+// - Return 0 on failure, otherwise return 1
+
+int hash_ctx_final (hash_ctx *hp, unsigned char *key, unsigned int *len)
+{
+	memset(key, 0x00, SHA256_DIGEST_LENGTH);
+	*len = SHA256_DIGEST_LENGTH;
+
+	switch (hp->algo) {
+#ifdef HAVE_BLAKE3
+	case HA_BLAKE3:
+		blake3_hasher_finalize(&hp->blake3, key, SHA256_DIGEST_LENGTH);
+		return 1;
+#endif
+#ifdef HAVE_XXHASH
+	case HA_XXH3: {
+		XXH128_canonical_t canon;
+		XXH128_canonicalFromHash(&canon, XXH3_128bits_digest(hp->xxh3));
+		memcpy(key, canon.digest, sizeof(canon.digest));
+		return 1;
+	}
+#endif
+	default:
+		return EVP_DigestFinal_ex(hp->md, key, len);
+	}
+}
@@ -0,0 +1,29 @@
+// This file, hash-engine.h, is a part of the Dedupe Entries program.
+// 
+// Copyright (C) 2025  David Hugh
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https:www.gnu.org/licenses/>.
+
+#ifndef hash_engine_h
+#define hash_engine_h
+
+const char *hash_algo_name (int);
+gboolean hash_algo_built (int);
+hash_ctx *hash_ctx_new (int);
+void hash_ctx_free (hash_ctx *);
+int hash_ctx_init (hash_ctx *);
+int hash_ctx_update (hash_ctx *, const void *, size_t);
+int hash_ctx_final (hash_ctx *, unsigned char *, unsigned int *);
+
+#endif
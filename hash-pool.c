@@ -0,0 +1,137 @@
+// This file, hash-pool.c, is a part of the Dedupe Entries program.
+// 
+// Copyright (C) 2025  David Hugh
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https:www.gnu.org/licenses/>.
+
+#include "main.h"
+#include "lib.h"
+#include "get-hash.h"
+#include "read-pipe.h"
+#include "hash-pool.h"
+#include "verify-group.h"
+
+static hash_job stop_job; // Sentinel telling a worker to exit
+
+// Take another job for a worker only if one is ready
+// - The stop sentinel is put back for the blocking pop to find
+// - Return NULL if nothing is ready
+
+hash_job *hash_pool_try_next (hash_pool *pool)
+{
+	hash_job *jp = g_async_queue_try_pop(pool->todo);
+	if (jp == &stop_job) {
+		g_async_queue_push(pool->todo, jp);
+		return NULL;
+	}
+	return jp;
+}
+
+// Worker thread
+// - Wait for a job, then run it and any other ready jobs through the read pipe
+// - A job leading a verification group is compared byte for byte instead
+// - Finished jobs are handed back to the scan thread by the pipe or the verify
+
+gpointer hash_worker_thread (hash_pool *pool)
+{
+	hash_worker worker;
+	hash_worker_init(&worker, &pool->cancel, pool->progress, pool->algo, pool->drop_cache);
+
+	while (TRUE) {
+		hash_job *jp = g_async_queue_pop(pool->todo);
+		if (jp == &stop_job) break;
+		if (jp->members) verify_group(&worker, jp, pool);
+		else read_pipe_run(worker.pipe, &worker, jp, pool);
+	}
+
+	hash_worker_clear(&worker);
+	return NULL;
+}
+
+// Start the workers, one per processor up to the max
+
+hash_pool *hash_pool_new (scan_progress *progress, int algo, gboolean drop_cache)
+{
+	hash_pool *pool = g_malloc0(sizeof(hash_pool));
+	pool->progress = progress;
+	pool->algo = algo;
+	pool->drop_cache = drop_cache;
+	pool->todo = g_async_queue_new();
+	pool->done = g_async_queue_new();
+	pool->n_threads = MIN(MAX_HASH_THREADS, MAX(1, g_get_num_processors()));
+
+	for (int i = 0; i < pool->n_threads; i++) {
+		pool->threads[i] = g_thread_new("hash", (GThreadFunc) hash_worker_thread, pool);
+	}
+	return pool;
+}
+
+// Commit a finished job to its item, only called on the scan thread
+// - Errors go to the result, a full hash is kept as the binary digest
+// - A good partial job only updates its key, so nothing to commit
+
+void commit_job (hash_job *jp)
+{
+	if (jp->error) {
+		jp->item->kind = RK_ERROR;
+		jp->item->error = jp->error;
+		return;
+	}
+	if (jp->stage != PS_N || jp->members || jp->tree) return; // Groups and tree leaves are committed through their files once done
+	memcpy(jp->item->digest, jp->key, SHA256_DIGEST_LENGTH);
+}
+
+// Run a set of jobs through the pool and wait for all of them
+// - Finished jobs are committed in batches on the scan thread, progress is left in the scan counters
+// - A cancel is latched so workers skip or stop their jobs
+// - Return 0 if cancel requested, otherwise return 1
+
+int hash_pool_run (hash_pool *pool, hash_job **jobs, uint32_t cnt, user_data *udp)
+{
+	scan_progress *pp = &udp->scan->progress;
+	g_atomic_int_set(&pp->done, 0);
+	g_atomic_int_set(&pp->total, cnt);
+
+	for (uint32_t i = 0; i < cnt; i++) g_async_queue_push(pool->todo, jobs[i]);
+
+	uint32_t done = 0;
+	while (done < cnt) {
+		// Wait briefly for a finished job, then take whatever else is ready as one batch
+		hash_job *jp = g_async_queue_timeout_pop(pool->done, HASH_WAIT);
+		uint32_t batch = 0;
+		while (jp) {
+			commit_job(jp);
+			done++;
+			if (!jp->tree) g_atomic_int_add(&pp->files, jp->members ? jp->members : 1); // A tree file counts once its root is made
+			if (++batch == HASH_BATCH) break;
+			jp = g_async_queue_try_pop(pool->done);
+		}
+		g_atomic_int_set(&pp->done, done);
+
+		if (g_atomic_int_get(&udp->cancel_request)) g_atomic_int_set(&pool->cancel, TRUE);
+	}
+
+	return !g_atomic_int_get(&pool->cancel);
+}
+
+// Stop the workers and free up the pool
+
+void hash_pool_free (hash_pool *pool)
+{
+	for (int i = 0; i < pool->n_threads; i++) g_async_queue_push(pool->todo, &stop_job);
+	for (int i = 0; i < pool->n_threads; i++) g_thread_join(pool->threads[i]);
+	g_async_queue_unref(pool->todo);
+	g_async_queue_unref(pool->done);
+	g_free(pool);
+}
@@ -0,0 +1,27 @@
+// This file, hash-pool.h, is a part of the Dedupe Entries program.
+// 
+// Copyright (C) 2025  David Hugh
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https:www.gnu.org/licenses/>.
+
+#ifndef hash_pool_h
+#define hash_pool_h
+
+hash_pool *hash_pool_new (scan_progress *, int, gboolean);
+hash_job *hash_pool_try_next (hash_pool *);
+void commit_job (hash_job *);
+int hash_pool_run (hash_pool *, hash_job **, uint32_t, user_data *);
+void hash_pool_free (hash_pool *);
+
+#endif
@@ -16,17 +16,16 @@
 // along with this program.  If not, see <https:www.gnu.org/licenses/>.
 
 #include "main.h"
+#include "dup-model.h"
 #include "install-property.h"
 
 G_DEFINE_TYPE(DupItem, dup_item, G_TYPE_OBJECT)
 
 // Have to start at 1 because 0 is reserved for G_TYPE_OBJECT   
+// - Only the name is a property, read only as it points into a scan arena
+// - The rest of the record is binary and formatted when shown
 typedef enum {
-	PROP_RESULT = 1,
-	PROP_NAME,
-	PROP_HASH,
-	PROP_FILE_SIZE,
-	PROP_MODIFIED,
+	PROP_NAME = 1,
 	N_PROPERTIES
 } DupItemProperty;
 
@@ -35,37 +34,29 @@ static void dup_item_init(DupItem *item)
 {
 }
 
-// Set the properties
-static void dup_item_set_property(GObject *object, uint32_t property_id, const GValue *value, GParamSpec *pspec)
+// Release the record array when the row goes
+static void dup_item_finalize(GObject *object)
 {
 	DupItem *self = (DupItem *) object;
+	g_array_unref(self->recs);
+	G_OBJECT_CLASS(dup_item_parent_class)->finalize(object);
+}
 
-	switch ((DupItemProperty) property_id) {
-
-	case PROP_RESULT:
-		self->result = g_value_dup_string(value);
-		break;
-
-	case PROP_NAME:
-		self->name = g_value_dup_string(value);
-		break;
+// Make a row object for a record, only done when a view asks for the row
 
-	case PROP_HASH:
-		self->hash = g_value_dup_string(value);
-		break;
+DupItem *dup_item_new (GArray *recs, uint32_t rec)
+{
+	DupItem *self = g_object_new(DUP_TYPE_ITEM, NULL);
+	self->recs = g_array_ref(recs);
+	self->rec = rec;
+	return self;
+}
 
-	case PROP_FILE_SIZE:
-		self->file_size = g_value_dup_string(value);
-		break;
+// Get the record behind a row
 
-	case PROP_MODIFIED:
-		self->modified = g_value_dup_string(value);
-		break;
-
-	default:
-		G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
-		break;
-	}
+dup_rec *dup_item_rec (DupItem *self)
+{
+	return &g_array_index(self->recs, dup_rec, self->rec);
 }
 
 // Get the property values from dup item object
@@ -75,24 +66,8 @@ void dup_item_get_property (GObject *object, uint32_t property_id, GValue *value
 
 	switch ((DupItemProperty) property_id) {
 
-	case PROP_RESULT:
-		g_value_set_string(value, self->result);
-		break;
-
 	case PROP_NAME:
-		g_value_set_string(value, self->name);
-		break;
-
-	case PROP_HASH:
-		g_value_set_string(value, self->hash);
-		break;
-
-	case PROP_FILE_SIZE:
-		g_value_set_string(value, self->file_size);
-		break;
-
-	case PROP_MODIFIED:
-		g_value_set_string(value, self->modified);
+		g_value_set_string(value, dup_item_rec(self)->name);
 		break;
 
 	default:
@@ -107,23 +82,13 @@ static GParamSpec *obj_properties[N_PROPERTIES] = { NULL, }; // Use in class ini
 static void dup_item_class_init(DupItemClass *klass)
 {
 
-	// Set and get properties for class
+	// Get properties and clean up for class
 	GObjectClass *object_class = G_OBJECT_CLASS(klass);
-	object_class->set_property = dup_item_set_property;
 	object_class->get_property = dup_item_get_property;
+	object_class->finalize = dup_item_finalize;
 
 	// Define param spec for each property
-	obj_properties[PROP_RESULT] = g_param_spec_string("result", "Result", "1 column is result", NULL, G_PARAM_READWRITE);
-
-	obj_properties[PROP_NAME] = g_param_spec_string("name", "Name", "2 column is name", NULL, G_PARAM_READWRITE);
-
-	obj_properties[PROP_HASH] = g_param_spec_string("hash", "Hash", "3 column is hash", NULL, G_PARAM_READWRITE);
-
-	obj_properties[PROP_FILE_SIZE] = g_param_spec_string("file_size", "File_size", "4 column is file size", NULL,
-							     G_PARAM_READWRITE);
-
-	obj_properties[PROP_MODIFIED] = g_param_spec_string("modified", "Modified", "5 column is modified", NULL,
-							    G_PARAM_READWRITE);
+	obj_properties[PROP_NAME] = g_param_spec_string("name", "Name", "2 column is name", NULL, G_PARAM_READABLE);
 
 	// Install properties
 	g_object_class_install_properties(object_class, N_PROPERTIES, obj_properties);
@@ -17,6 +17,7 @@
 
 #include "main.h"
 #include "load-store.h"
+#include "dup-model.h"
 #include "lib.h"
 
 // Cean up pending events
@@ -28,31 +29,143 @@ void do_pending ()
 
 // Used when debugging programs
 
-void see_entry_data (GListStore *list_store, GtkMultiSelection *selection)
+void see_entry_data (DupModel *list_store, GtkMultiSelection *selection)
 { 
-        int cnt = g_list_model_get_n_items (G_LIST_MODEL (list_store));
+        int cnt = dup_model_n (list_store);
 
         // Print out file data from the store to stdout
         for (int i = 0; i < cnt; i++)   {
 
-                DupItem *item = g_list_model_get_item (G_LIST_MODEL (list_store), i);
-                if (item == NULL) {
-                        printf ("Error: item is NULL\n");
-                        return;
-                }
-                printf ("\nRecord: %d Result: %s Result Ptr: %p", i, item->result, item->result);
-                printf (" Name: %s Name Ptr: %p\n", item->name, item->name);
+                dup_rec *item = dup_model_rec (list_store, i);
+                char result[STR_RESULT], hash[STR_HASH], modified[STR_MODIFIED];
+                printf ("\nRecord: %d Result: %s Kind: %d", i, item_result_text(item, result, sizeof(result)), item->kind);
+                printf (" Dir: %u Name: %s Name Ptr: %p\n", item->dir, item->name, item->name);
 
-                printf ("Hash: %s", item->hash); 
+                printf ("Hash: %s", item_hash_text(item, hash)); 
 
-                printf (" Size: %s", item->file_size);
-                printf (" Modified: %s\n", item->modified);
+                printf (" Size: %lu", item->size);
+                printf (" Modified: %s\n", item_modified_text(item, modified, sizeof(modified)));
 
                 if (selection) 
                         printf ("Selected?: %s\n", gtk_selection_model_is_selected(GTK_SELECTION_MODEL (selection) , i) ? "Yes" : "No");
 	}
 }
 
+// Split an item's full path into directory, separator and base name without joining them
+// - A directory's own entry has no base name, its path is the directory
+
+void item_path_parts (dup_rec *item, user_data *udp, const char *parts[3])
+{
+	const char *dir = g_ptr_array_index(udp->dirs, item->dir);
+	parts[0] = dir;
+	parts[1] = (!item->name || dir[strlen(dir) - 1] == '/') ? "" : "/"; // Don't want to add a forward slash if root
+	parts[2] = item->name ? item->name : "";
+}
+
+// Get an item's full path, for display and anything working on the file
+// - Buff must hold STR_PATH
+
+const char *item_path (dup_rec *item, user_data *udp, char *buff)
+{
+	const char *parts[3];
+	item_path_parts(item, udp, parts);
+	snprintf(buff, STR_PATH, "%s%s%s", parts[0], parts[1], parts[2]);
+	return buff;
+}
+
+// Get the length of an item's full path without building it
+
+size_t item_path_len (dup_rec *item, user_data *udp)
+{
+	const char *parts[3];
+	item_path_parts(item, udp, parts);
+	return strlen(parts[0]) + strlen(parts[1]) + strlen(parts[2]);
+}
+
+// Compare the full paths of two items, same result as strcmp on the joined paths
+// - Items in the same directory only compare base names
+// - Otherwise walks the parts of each path in step, nothing is joined
+
+int cmp_item_name (dup_rec *item1, dup_rec *item2, user_data *udp)
+{
+	if (item1->dir == item2->dir && item1->name && item2->name) return strcmp(item1->name, item2->name);
+
+	const char *p1[3], *p2[3];
+	item_path_parts(item1, udp, p1);
+	item_path_parts(item2, udp, p2);
+
+	int i1 = 0, i2 = 0;
+	const char *c1 = p1[0], *c2 = p2[0];
+	while (TRUE) {
+		while (!*c1 && i1 < 2) c1 = p1[++i1];
+		while (!*c2 && i2 < 2) c2 = p2[++i2];
+		if (*c1 != *c2 || !*c1) return (unsigned char) *c1 - (unsigned char) *c2;
+		c1++;
+		c2++;
+	}
+}
+
+// Get the result text for an item
+// - Groups show as 7 digits, the rest are fixed text, nothing is stored on the item
+// - Return the text, which is either buff or a constant
+
+const char *item_result_text (dup_rec *item, char *buff, size_t size)
+{
+	switch (item->kind) {
+	case RK_GROUP:
+		snprintf(buff, size, "%07u", item->group);
+		return buff;
+	case RK_DIR:
+		return STR_DIR;
+	case RK_EMPTY:
+		return STR_EMP;
+	case RK_ERROR:
+		return item->error;
+	case RK_LINK:
+		return STR_LNK;
+	case RK_UNIQUE:
+		return STR_UNI;
+	default:
+		return "";
+	}
+}
+
+// Get the hash of an item as hex digits, empty if the item was never hashed
+// - Buff must hold STR_HASH
+
+const char *item_hash_text (dup_rec *item, char *buff)
+{
+	buff[0] = 0x00;
+	if (item->kind != RK_GROUP && item->kind != RK_UNIQUE) return buff;
+	for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) snprintf(buff + i * 2, 3, "%02x", item->digest[i]);
+	return buff;
+}
+
+// Get the modified time of an item as local time text, empty for directories and errors
+
+const char *item_modified_text (dup_rec *item, char *buff, size_t size)
+{
+	struct tm tinfo;
+	buff[0] = 0x00;
+	if (item->kind == RK_DIR || item->kind == RK_ERROR) return buff;
+
+	time_t mtime = item->mtime_ns / 1000000000;
+	localtime_r(&mtime, &tinfo);
+	strftime(buff, size, "%F %H:%M:%S", &tinfo);
+	return buff;
+}
+
+// Compare the results of two items, same order the result text would sort in
+// - Kind first, then group number, then error text
+
+int cmp_result (dup_rec *item1, dup_rec *item2)
+{
+	if (item1->kind != item2->kind) return item1->kind - item2->kind;
+	if (item1->kind == RK_GROUP) return (item1->group > item2->group) - (item1->group < item2->group);
+	if (item1->kind == RK_ERROR) return strcmp(item1->error, item2->error);
+	return 0;
+}
+
 // Cancel clean up
 // - For cancel remove any entries from list store (could be partial and misleading)
 // - Clear the folders 
@@ -94,7 +207,7 @@ void clear_folders (char *fopp[MAX_FOLDERS])
 void adjust_sfs_button_sensitivity (user_data *udp)
 {
        if (udp->list_store && 
-           g_list_model_get_n_items(G_LIST_MODEL(udp->list_store)) > 0 &&
+           dup_model_n(udp->list_store) > 0 &&
            !udp->auto_dedupe) {
                gtk_widget_set_sensitive(udp->sort_button, TRUE);
                gtk_widget_set_sensitive(udp->filter_button, TRUE);
@@ -115,30 +228,12 @@ void wipe_selected(user_data *udp)
         gtk_bitset_remove_all (udp->sel_bitset);
 }
 
-// Free up a store's item memory
- 
-void free_item_memory (DupItem *item)
-{
-        g_free((const gpointer)item->result);  
-        g_free((const gpointer)item->name);  
-        g_free((const gpointer)item->hash);
-        g_free((const gpointer)item->file_size);
-        g_free((const gpointer)item->modified);
-}
-
 // Clear the store items
-// - Have to free up the memory allocated for each string
-// - Gio remove doesn't free up the memory
+// - Item names live in the scan arenas, freed at once in clear_stores, so nothing per item
 
-void clear_store_items(GListStore *list_store)
+void clear_store_items(DupModel *list_store)
 {
-        uint32_t cnt = g_list_model_get_n_items(G_LIST_MODEL(list_store));
-        for (int i = 0; i < cnt; i++) {
-                DupItem *item = g_list_model_get_item(G_LIST_MODEL(list_store), i); 
-                free_item_memory(item);  
-                g_object_unref(item);
-        }
-        g_list_store_remove_all(list_store);
+        dup_model_remove_all(list_store);
 }
 
 void clear_stores(user_data *udp)
@@ -149,12 +244,12 @@ void clear_stores(user_data *udp)
                 g_object_unref(udp->org_list_store);
 		udp->org_list_store = NULL;
                 if (udp->filtered_list_store) {
-                        g_list_store_remove_all(udp->filtered_list_store);
+                        dup_model_remove_all(udp->filtered_list_store);
                         g_object_unref(udp->filtered_list_store);
 			udp->list_store = NULL;
                 }
                 if (udp->list_store) {
-                        g_list_store_remove_all(udp->list_store);
+                        dup_model_remove_all(udp->list_store);
                         g_object_unref(udp->list_store);
 			udp->list_store = NULL;
                 }
@@ -164,6 +259,16 @@ void clear_stores(user_data *udp)
                 g_object_unref(udp->list_store);
 		udp->list_store = NULL;
         } 
+
+	// Drop the interned directories and name arenas last, the items point into them
+	if (udp->dirs) {
+		g_ptr_array_unref(udp->dirs);
+		udp->dirs = NULL;
+	}
+	if (udp->arenas) {
+		g_ptr_array_unref(udp->arenas);
+		udp->arenas = NULL;
+	}
 }
 
 // Read options from file
@@ -202,8 +307,9 @@ void option_init (user_data *udp)
         // Read any saved options in gvariant serialized format
         unsigned char buff[OPTION_STORAGE] = {0x00};
         if (read_options(buff, udp->opt_name)) {
-                GVariant *value = g_variant_new("(bbbbbybb)", buff[0], buff[1], buff[2], buff[3], buff[4], buff[5], buff[6], buff[7]);
-                g_variant_get(value, "(bbbbbybb)", &udp->opt_include_hidden, &udp->opt_include_directory, &udp->opt_include_empty, &udp->opt_include_duplicate, &udp->opt_include_unique, &udp->opt_preserve, &udp->opt_manual_prompt, &udp->opt_auto_prompt);
+                // An options file from before the later options reads short, leaving them 0 for SHA256, keeping the page cache and no verify
+                GVariant *value = g_variant_new("(bbbbbybbybb)", buff[0], buff[1], buff[2], buff[3], buff[4], buff[5], buff[6], buff[7], buff[8], buff[9], buff[10]);
+                g_variant_get(value, "(bbbbbybbybb)", &udp->opt_include_hidden, &udp->opt_include_directory, &udp->opt_include_empty, &udp->opt_include_duplicate, &udp->opt_include_unique, &udp->opt_preserve, &udp->opt_manual_prompt, &udp->opt_auto_prompt, &udp->opt_hash, &udp->opt_drop_cache, &udp->opt_verify);
                 g_variant_unref(value);
 	}
         else {
@@ -215,5 +321,8 @@ void option_init (user_data *udp)
                 udp->opt_preserve = AP_SHORTEST; // Default to preserve shortest name in group of duplicates
                 udp->opt_manual_prompt = TRUE; // Default to prompt for manual get/select trash
                 udp->opt_auto_prompt = TRUE; // Default to prompt for auto trash
+                udp->opt_hash = HA_SHA256; // Default to SHA256 hashing
+                udp->opt_drop_cache = FALSE; // Default to let hashed files stay cached
+                udp->opt_verify = FALSE; // Default to trust a full hash match
         }
 }
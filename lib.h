@@ -24,9 +24,15 @@ void clear_folders (char *[MAX_FOLDERS]);
 void adjust_sfs_button_sensitivity(user_data *);
 void wipe_selected(user_data *);
 void clear_stores(user_data *);
-void free_item_memory(DupItem *);
-void clear_store_items(GListStore *);
-void see_entry_data(GListStore *, GtkMultiSelection *);
+void clear_store_items(DupModel *);
+void see_entry_data(DupModel *, GtkMultiSelection *);
+const char *item_path (dup_rec *, user_data *, char *);
+size_t item_path_len (dup_rec *, user_data *);
+int cmp_item_name (dup_rec *, dup_rec *, user_data *);
+const char *item_result_text (dup_rec *, char *, size_t);
+const char *item_hash_text (dup_rec *, char *);
+const char *item_modified_text (dup_rec *, char *, size_t);
+int cmp_result (dup_rec *, dup_rec *);
 gboolean read_options(unsigned char *, char *);
 
 #endif
@@ -16,19 +16,18 @@
 // along with this program.  If not, see <https:www.gnu.org/licenses/>.
 
 #include "main.h"
+#include "dup-model.h"
 #include "show-columns.h"
-#include "traverse.h"
-#include "get-results.h"
+#include "scan-engine.h"
 #include "work-auto.h"
 #include "lib.h"
 #include "load-store.h"
 
-// Cancel button hit, set cancel to true and do cleanup when cycles available
+// Cancel button hit, set cancel to true, clean up is done when the scan returns
 
 void cancel_cb (GtkWidget *self, user_data *udp)
 {
-	udp->cancel_request = TRUE;
-	g_idle_add((GSourceFunc) cancel_clean_up, udp);
+	g_atomic_int_set(&udp->cancel_request, TRUE); // Scan threads read it
 }
 
 // Default sort compare
@@ -36,52 +35,56 @@ void cancel_cb (GtkWidget *self, user_data *udp)
 
 int default_sort_cmp (const void *a, const void *b, user_data *udp)
 {
-        DupItem *item1 = (DupItem *) a;
-        DupItem *item2 = (DupItem *) b;
-        if (!strcmp(item1->result, item2->result)) 
-		return (strcmp(item1->name, item2->name)); 
+        dup_rec *item1 = (dup_rec *) a;
+        dup_rec *item2 = (dup_rec *) b;
+        if (!cmp_result(item1, item2)) 
+		return (cmp_item_name(item1, item2, udp)); 
         else 
-                return (strcmp(item1->result, item2->result));
+                return (cmp_result(item1, item2));
 }
-// Exclude the empty, directory, group and unique items if not directed to be included in options
 
-void exclude_items (user_data *udp)
+// See if an item is wanted given the scan's include options
+
+gboolean include_item (dup_rec *item, user_data *udp)
 {
-	// Get count of items in list store
-	uint32_t cnt = g_list_model_get_n_items(G_LIST_MODEL(udp->list_store));
-
-	for (int i = 0; i < cnt; i++) {
-		DupItem *item = g_list_model_get_item(G_LIST_MODEL(udp->list_store), i);
-		if ((!udp->opt_include_unique && !strcmp(item->result, STR_UNI)) ||
-		    (!udp->opt_include_directory && !strcmp(item->result, STR_DIR)) ||
-		    (!udp->opt_include_empty && !strcmp(item->result, STR_EMP)) ||
-		    (!udp->opt_include_duplicate && isdigit(item->result[0]))) {
-			free_item_memory(item);
-			g_list_store_remove(udp->list_store, i);
-			i--; // Adjust for removed item
-			cnt--; // Adjust for removed item
-		}
-		g_object_unref(item);
-	}
+	scan_state *sp = udp->scan;
+	return !(item->kind == RK_REPEAT ||
+		 (!sp->include_unique && item->kind == RK_UNIQUE) ||
+		 (!sp->include_directory && item->kind == RK_DIR) ||
+		 (!sp->include_empty && item->kind == RK_EMPTY) ||
+		 (!sp->include_duplicate && (item->kind == RK_GROUP || item->kind == RK_LINK)));
+}
+
+// Finalize the scan once all roots are walked, hashed and grouped
+// - Drop the empty, directory, group and unique items not directed to be included in options, and any repeats
+// - Then the one default sort, the order is handed to the store with the records in one splice
+
+void finalize_store (user_data *udp)
+{
+	scan_state *sp = udp->scan;
+	gboolean all = sp->include_unique && sp->include_directory && sp->include_empty && sp->include_duplicate && !sp->repeats;
+	sp->order = dup_order_new(sp->recs, all ? NULL : (gboolean (*)(dup_rec *, gpointer)) include_item,
+				  (GCompareDataFunc) default_sort_cmp, udp);
 }
 
 // Drive getting and showing entry duplicates and data
 // - Create the store
 // - Setup the progress box, progress bar, and cancel button
-// - Launch a traverse of each folder and store the entry data in the list store
-// - Using the entry data, determine duplicates and other values for the result column
-// - Parse out any unwanted result types
-// - Launch and show the data in the columns OR auto dedupe
-// - Can re-enter multiple times (mutliple gets)
+// - Start the scan, it walks, hashes, groups and finalizes off the main thread
+// - The scan hands back to show_entry_data when done
+// - Can re-enter multiple times (mutliple gets), but only one scan at a time
 
 void load_entry_data (user_data *udp)
 {
+	if (udp->scan) return; // Already scanning
+
 	clear_stores(udp); // Clear the stores and associated item memory
 
 	if (!udp->list_store) {
-		GListStore *list_store = g_list_store_new(G_TYPE_OBJECT);
+		DupModel *list_store = dup_model_new(NULL);
 		udp->list_store = list_store; // Save pointer to list store
 	}
+	adjust_sfs_button_sensitivity(udp); // Nothing to sort, filter or search while scanning
 
 	// Remove and collect any existing child
 	gtk_window_set_child(GTK_WINDOW(udp->main_window), NULL);
@@ -103,26 +106,16 @@ void load_entry_data (user_data *udp)
 	gtk_widget_set_halign(cancel_button, GTK_ALIGN_CENTER);
 	g_signal_connect(cancel_button, "clicked", G_CALLBACK(cancel_cb), udp);
 
-	// Loop through the directory pointer array and gather entry data               
-	for (int i = 0; udp->fdpp[i]; i++) { // If fdpp[i] is NULL, then no more directories
-
-		// Recursively load store with directory and entry data
-		if (!traverse(udp->fdpp[i], udp)) break; // 0 for show stopper 
-
-		// No show stopper (0) so get results 
-		if (!get_results(udp)) break;
-
-		// No show stopper (0) so check to see if result type should be included
-		if (!udp->opt_include_unique || !udp->opt_include_directory ||
-	       	    !udp->opt_include_empty || !udp->opt_include_duplicate)
- 			exclude_items(udp);
-
-		g_list_store_sort(udp->list_store, (GCompareDataFunc) default_sort_cmp, NULL);
+	start_scan(udp);
+}
 
-	} // End for
+// Show the entry data once the scan has published it
+// - Launch and show the data in the columns OR auto dedupe
 
+void show_entry_data (user_data *udp)
+{
 	// If something to work do manual or auto follow on
-	if (!udp->ut_active && g_list_model_get_n_items(G_LIST_MODEL(udp->list_store))) {
+	if (!udp->ut_active && dup_model_n(udp->list_store)) {
 		adjust_sfs_button_sensitivity(udp);
 		if (!udp->auto_dedupe) show_columns(udp); // Show and select for actions
 		else work_auto(udp); // Auto dedupe
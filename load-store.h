@@ -18,8 +18,9 @@
 #ifndef load_file_data_h
 #define load_file_data_h
 
-void clear_store_items (GListStore *);
-void clean_up (user_data *);
+gboolean include_item (dup_rec *, user_data *);
+void finalize_store (user_data *);
 void load_entry_data (user_data *);
+void show_entry_data (user_data *);
 
 #endif
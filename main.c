@@ -23,6 +23,7 @@
 #include "load-store.h"
 #include "search.h"
 #include "about.h"
+#include "scan-engine.h"
 #include "lib.h"
 
 
@@ -30,10 +31,18 @@
 
 void auto_cb (GtkWidget *self, user_data *udp)
 {
+	if (udp->scan) return; // One scan at a time
 	udp->auto_dedupe = TRUE;
 	get_folders_cb(self, udp);
 }
 
+// Main window closing, stop any scan first so it can't outlive the window and data
+
+gboolean main_window_close_cb (GtkWindow *self, user_data *udp)
+{
+	stop_scan(udp);
+	return FALSE; // False to allow the default window close to run
+}
 
 // Create the main window
 // - Buttons get, sort, filter, auto
@@ -52,6 +61,7 @@ void main_window (GtkApplication *app, user_data *udp)
 	udp->main_window = main_window;
 	gtk_window_set_title(GTK_WINDOW(main_window), "Dedupe Entries");
 	gtk_window_set_default_size(GTK_WINDOW(main_window), 1024, 256);
+	g_signal_connect(main_window, "close-request", G_CALLBACK(main_window_close_cb), udp);
 
 	// Create header bar to use as titlebar
 	GtkWidget *header_bar = gtk_header_bar_new();
@@ -20,28 +20,85 @@
 
 #include <gtk/gtk.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <stdint.h>
 #include <limits.h>
 #include <openssl/evp.h> // For hash calculation
 #include <assert.h> // for debugging
 #include <ctype.h> 
 #include <libgen.h> 
+#include <sys/mman.h> // For mapped hashing of large files
+#include <sys/vfs.h> 
+#include <linux/magic.h> // Filesystem types, to map local files and spot network mounts
+#ifndef CIFS_SUPER_MAGIC
+#define CIFS_SUPER_MAGIC 0xFF534D42 // Older kernel headers call it CIFS_MAGIC_NUMBER
+#endif
+#ifndef SMB2_SUPER_MAGIC
+#define SMB2_SUPER_MAGIC 0xFE534D42
+#endif
+#ifndef FUSE_SUPER_MAGIC
+#define FUSE_SUPER_MAGIC 0x65735546
+#endif
+#include <setjmp.h> // Recover from a mapped file truncated while hashing
+#include <signal.h> 
+#include <sys/resource.h> // Open file limit, shared among verifying workers
+#ifdef HAVE_LIBURING
+#include <liburing.h> // Optional async reads for hashing
+#endif
+#ifdef HAVE_BLAKE3
+#include <blake3.h> // Optional BLAKE3 hash engine
+#endif
+#ifdef HAVE_XXHASH
+#include <xxhash.h> // Optional XXH3 hash engine
+#endif
 
 // General
 #define READ_BUFF 16384 // Arbitrary
-#define OPTION_STORAGE 8 // Byte count for gvariant - 7 bool bytes and 1 char byte
-#define SHA256_DIGEST_LENGTH 32 // SHA256 hash length
+#define OPTION_STORAGE 11 // Byte count for gvariant - 9 bool bytes and 2 char bytes
+#define SHA256_DIGEST_LENGTH 32 // SHA256 hash length, every hash engine fills a key this long
 #define FORMAT_UNIT 16 // Number of bytes to format on each line for view file
+#define PARTIAL_BUFF 4096 // Sample block size for partial hash stages
+#define PARTIAL_MIN (64 * 1024) // Smaller files go straight to a full hash
+#define PARTIAL_MIDDLE_MIN (1024 * 1024) // Smallest file to also sample the middle
 
 // Limits
 #define MAX_FOLDERS 20 // Arbitrary
 #define MAX_ENTRIES 9999999 // Arbitrary 
 #define MAX_GROUPS (MAX_ENTRIES / 2) // Arbitrary
+#define MAX_HASH_THREADS 16 // Upper bound on hashing workers
+#define HASH_BATCH 256 // Most finished hash jobs committed per main loop pass
+#define HASH_WAIT 50000 // Microseconds to wait for a finished hash job
+#define PROGRESS_TICK 250000 // Microseconds of frame time between progress text updates
+#define PIPE_CHUNK (128 * 1024) // Bytes per read in the hashing read pipe
+#define PIPE_DEPTH 16 // Reads in flight per hashing worker
+#define PIPE_FILES 8 // Files a hashing worker streams at once
+#define PIPE_PER_FILE 4 // Reads in flight for any one file
+#define PIPE_ALIGN 4096 // Read buffer alignment
+#define MAP_MIN (64 * 1024 * 1024) // Hash ranges this large from a mapping instead of the read pipe
+#define MAP_WINDOW (8 * 1024 * 1024) // Bytes of a mapping hashed before the pages behind are dropped
+#define VERIFY_CHUNK (1024 * 1024) // Bytes of each member compared at a time when verifying a group
+#define VERIFY_FDS 128 // Most files a verifying worker keeps open between chunks, the rest are reopened per chunk
+#define VERIFY_RESERVE 256 // Descriptors left for the rest of the app when sharing the open file limit among verifying workers
+#define VERIFY_RETRY 20 // Waits for a free descriptor before a member read fails
+#define TREE_MIN (1024ULL * 1024 * 1024) // Files this large are fully hashed as a tree of leaves across the workers
+#define TREE_LEAF (256ULL * 1024 * 1024) // Bytes of a file hashed by one tree leaf
+#define MAX_WALK_THREADS 16 // Upper bound on directory walkers
+#define WALK_BATCH 512 // Most walked entries handed to the scan thread at once
+#define WALK_IDLE 1000 // Microseconds an idle walker waits before looking for work again
+#define WALK_WAIT 50000 // Microseconds to wait for walked entries
+#define WALK_MAX_FDS 256 // Most directory fds held open by queued directories
+#define DIRENT_BUFF (1024 * 1024) // Per walker getdents64 buffer, larger means fewer syscalls on huge directories
+#define NAME_ARENA (256 * 1024) // Block size of the per walker base name arenas
+#define CACHE_INIT_CAP (1 << 16) // Starting hash cache slots, always a power of two
+#define CACHE_MAGIC 0x3230484345505544ULL // "DUPECH02" marks a usable hash cache file, 02 since huge files hash as a tree
 
 // Char buffer sizes for strings
 #define STR_PATH PATH_MAX // From limits.h includes null
 #define STR_BNAME (NAME_MAX + 1) // From limits.h add null
 #define STR_HASH (SHA256_DIGEST_LENGTH * 2) + 1 // Two asci hex digits for hash byte + Null
+#define STR_RESULT 64 // Result text, a group number or the longest error
+#define STR_MODIFIED 32 // Modified time text
+#define STR_TITLE 256 // Main window title with the group totals
 #define STR_CLIP (STR_PATH * 1000) + 1 // Clipboard mostly for small groups
 #define STR_ENTRY 256 // Entry buff sizes for search and filter
 #define STR_LINE 129 // Size of buff for view file lines
@@ -52,13 +109,20 @@
 #define STR_EMP "Empty\0"
 #define STR_ERR "Error\0"
 #define STR_UNI "Unique\0"
+#define STR_LNK "Link\0"
 #define STR_SPACE " \0"
 #define STR_CONFIG "/.config/dedupe-entries.cfg\0"
+#define STR_CACHE "/.cache/dedupe-entries\0" // Hash cache name, an engine suffix and STR_CACHE_EXT follow
+#define STR_CACHE_EXT ".db\0"
 
-// Define the DupItem GObject type
+// Define the DupItem GObject type, a row made on demand for a view
 #define DUP_TYPE_ITEM (dup_item_get_type ())
 G_DECLARE_FINAL_TYPE (DupItem, dup_item, DUP, ITEM, GObject)
 
+// Define the DupModel GObject type, the list model over the records
+#define DUP_TYPE_MODEL (dup_model_get_type ())
+G_DECLARE_FINAL_TYPE (DupModel, dup_model, DUP, MODEL, GObject)
+
 // Enum and array for auto preserve option
 
 enum auto_pre {
@@ -71,17 +135,370 @@ enum auto_pre {
 	AP_N
 };
 
+// Enum for result kinds
+// - Ordered as the result text sorts, group numbers first, so sorting by kind keeps the old order
+
+enum result_kind {
+	RK_NONE, // Not decided yet, a file waiting on its hash
+	RK_GROUP,
+	RK_DIR,
+	RK_EMPTY,
+	RK_ERROR,
+	RK_LINK,
+	RK_UNIQUE,
+	RK_REPEAT // The same directory entry reached again through overlapping roots or a mount, never shown
+};
+
+// Enum for the hash engines, saved in the options and the hash cache so keep the order
+
+enum hash_algo {
+	HA_SHA256,
+	HA_BLAKE3, // Only if built with HAVE_BLAKE3
+	HA_XXH3, // Only if built with HAVE_XXHASH, 128 bit, for trusted local data
+	HA_N
+};
+
+// Enum for partial hash sample stages, run in order ahead of a full hash
+
+enum partial_stage {
+	PS_HEAD,
+	PS_TAIL,
+	PS_MIDDLE,
+	PS_N
+};
+
+// Enum for read pipe slot states
+
+enum slot_state {
+	SLOT_FREE,
+	SLOT_BUSY,
+	SLOT_DONE
+};
+
+// Enum for the kinds of walked entries
+
+enum walk_kind {
+	WE_DIR,
+	WE_FILE,
+	WE_ERROR
+};
+
+// Enum for the scan phases, shown by the progress tick
+
+enum scan_phase {
+	SP_WALK,
+	SP_SAMPLE,
+	SP_HASH,
+	SP_VERIFY,
+	SP_GROUP
+};
+
 // Key type
+// - One plain record per entry, all held in one array
+
+typedef struct dup_rec {
+        const char *name; // Base name in a scan arena, NULL for a directory's own entry
+        uint32_t dir; // Parent directory, indexes the interned directory paths in udp->dirs
+        const char *error; // Static error text when kind is RK_ERROR, never freed
+        unsigned char digest[SHA256_DIGEST_LENGTH]; // Full hash, binary
+        uint64_t size; // Raw file size, used to prune hash candidates
+        uint64_t dev; // Device, inode and nanosecond mtime identify the file in the hash cache
+        uint64_t ino;
+        int64_t mtime_ns;
+        uint32_t nlink; // Hardlink count when scanned, trashing a linked file frees nothing
+        uint32_t group; // Duplicate group number when kind is RK_GROUP
+        int kind; // Result kind, text is only formatted for display
+} dup_rec;
+
+// Row object for a record, only made for rows a view binds
 
 struct _DupItem {
         GObject parent_instance;
-        const char *result;
-        const char *name;
-        const char *hash;
-        const char *file_size;
-        const char *modified;
+        GArray *recs; // Holds a reference so the record outlives a clear
+        uint32_t rec; // Index of the record
 };
 
+// List model over the records
+// - Positions map to records through the order, so sorting and filtering never move a record
+// - Models made by filtering share the record array
+
+struct _DupModel {
+        GObject parent_instance;
+        GArray *recs; // dup_rec
+        GArray *order; // uint32_t record index for each position
+};
+
+// Entry metadata, only the fields the scan needs
+
+typedef struct entry_meta {
+	mode_t mode; // File type bits only
+	uint64_t size;
+	int64_t mtime_ns;
+	uint64_t dev;
+	uint64_t ino;
+	uint32_t nlink;
+} entry_meta;
+
+// A key's members while grouping, the group is 0 until a second member is seen
+
+typedef struct group_tally {
+	uint32_t group;
+	uint32_t files;
+	uint32_t unlinked; // Members with no other hardlink, only trashing these frees space
+	uint64_t size;
+} group_tally;
+
+// Totals for the groups found by a get
+
+typedef struct group_totals {
+	uint32_t groups;
+	uint32_t files; // Files in all groups
+	uint32_t largest; // Members in the largest group
+	uint64_t reclaim; // Bytes freed by keeping one member of each group
+	int algo; // Hash engine the groups were found with
+	gboolean drop_cache; // Hashed without keeping file pages cached
+	gboolean verified; // Groups were compared byte for byte, not by full hash
+} group_totals;
+
+// A name from a directory read, points into the reader buffer
+
+typedef struct dir_name {
+	const char *name;
+	uint64_t ino;
+	unsigned char type; // DT_ type, may be DT_UNKNOWN
+} dir_name;
+
+// Batched directory reader over getdents64
+
+typedef struct dir_reader {
+	int fd;
+	char *buff;
+	size_t size;
+	dir_name *names; // Names from the last batch
+	int n_names;
+} dir_reader;
+
+// A walked entry, made on a walker thread and stored on the scan thread
+
+typedef struct walk_entry {
+	int kind;
+	char *dir; // Shared directory path, a GRefString
+	const char *base; // Base name in the walker's arena, NULL when the entry is the directory itself
+	const char *error; // Error text for WE_ERROR
+	entry_meta meta;
+} walk_entry;
+
+// A directory waiting to be read
+// - Held open relative to its parent when fds allow, otherwise opened by path
+
+typedef struct walk_dir {
+	char *path; // GRefString, shared with the entries found in it
+	int fd; // -1 if not yet opened
+} walk_dir;
+
+// A walker's own deque of directories still to read, others may steal from it
+
+typedef struct walk_deque {
+	GMutex lock;
+	GQueue dirs;
+} walk_deque;
+
+// Thread argument for a walker
+
+typedef struct walk_arg {
+	struct walker *wp;
+	int id;
+	GStringChunk *names; // Walker's own arena for base names, only this walker adds to it
+} walk_arg;
+
+// Parallel directory walker shared by the walker threads
+
+typedef struct walker {
+	walk_deque deques[MAX_WALK_THREADS];
+	walk_arg args[MAX_WALK_THREADS];
+	GThread *threads[MAX_WALK_THREADS];
+	int n_threads;
+	int pending; // Directories queued or being read
+	int running; // Walker threads not yet finished
+	int open_fds; // Directory fds held by queued directories
+	int cancel; // Set to stop the walkers early
+	gboolean include_hidden;
+	GAsyncQueue *found; // Batches of walked entries for the scan thread
+} walker;
+
+// Counters the scan bumps from its threads, read by the progress tick on the main thread
+
+typedef struct scan_progress {
+	int phase;
+	int stage; // Sample stage while sampling
+	int found; // Entries walked
+	gsize walked; // Bytes in the files walked
+	int done; // Jobs finished in the current phase
+	int total; // Jobs queued in the current phase
+	int files; // Candidate files finished in all phases, a verify group or tree counts its files not its jobs
+	gsize bytes; // Bytes read and hashed in all phases, bumped once per pipe read
+	gsize planned; // Bytes all the hashing should read, shrinks as the stages prune
+} scan_progress;
+
+// A unit of hashing work
+// - Workers fill in key and error, the scan thread commits them to the item
+
+typedef struct hash_job {
+	dup_rec *item; // Only touched on the scan thread
+	const char *name; // Path to read, built once the candidates are known
+	uint64_t size;
+	int stage; // Partial stage, or PS_N for a full hash
+	unsigned char key[SHA256_DIGEST_LENGTH]; // Chained partial key, then the full digest, every engine gives 32 bytes
+	uint32_t md_len;
+	const char *error; // Error text if the job failed, NULL otherwise
+	gboolean cached; // Full digest found in the hash cache, so no full read needed
+	unsigned char digest[SHA256_DIGEST_LENGTH]; // Cached full digest
+	uint32_t members; // Members of the verification group this job leads, 0 otherwise
+	struct hash_job *tree; // File job this job is a tree leaf of, NULL otherwise
+	uint64_t offset; // Start of a tree leaf
+} hash_job;
+
+// One class's chunk when verifying a group, keyed on the class it came from and its bytes
+
+typedef struct verify_rep {
+	uint32_t parent; // Class the members were in before this chunk
+	uint32_t cls; // Class the members are in from this chunk on
+	guint hash; // Of the parent and the bytes
+	size_t len;
+	unsigned char *buff;
+} verify_rep;
+
+// One read in the pipe, in flight or waiting to be hashed in order
+
+typedef struct pipe_slot {
+	unsigned char *buff;
+	int state; // SLOT_FREE, SLOT_BUSY or SLOT_DONE
+	int stream; // Stream the read belongs to
+	uint64_t offset;
+	size_t len;
+	ssize_t res; // Bytes read, or negative on error
+} pipe_slot;
+
+// Digest state for one file, for whichever engine the scan uses
+
+typedef struct hash_ctx {
+	int algo;
+	EVP_MD_CTX *md; // SHA256
+	EVP_MD *type; // Fetched once, so starting a digest doesn't look it up again
+#ifdef HAVE_BLAKE3
+	blake3_hasher blake3;
+#endif
+#ifdef HAVE_XXHASH
+	XXH3_state_t *xxh3;
+#endif
+} hash_ctx;
+
+// One file being hashed through the pipe
+
+typedef struct pipe_stream {
+	hash_job *jp; // NULL when the stream is free
+	int fd;
+	uint64_t next_read; // Next offset to submit
+	uint64_t next_hash; // Next offset to feed the digest, reads can finish out of order
+	uint64_t end;
+	int in_flight;
+	hash_ctx *hctx; // Reused for every file through this stream
+} pipe_stream;
+
+// Per worker read pipe, keeps reads in flight across several files while hashing
+
+typedef struct read_pipe {
+	pipe_slot slots[PIPE_DEPTH];
+	pipe_stream streams[PIPE_FILES];
+	int busy; // Slots in flight
+	int next_stream; // Round robin start for submitting reads
+	gboolean drop_cache; // Drop hashed pages from the page cache behind the reads
+#ifdef HAVE_LIBURING
+	struct io_uring ring;
+	gboolean uring; // True if the ring was setup, otherwise plain pread
+	int queued; // Reads prepared but not yet submitted to the ring
+#endif
+} read_pipe;
+
+// Per thread hashing state, reused for every job a worker runs
+
+typedef struct hash_worker {
+	read_pipe *pipe;
+	int *cancel; // Latched cancel flag shared with the pool
+	scan_progress *progress; // Scan counters, bytes are added as reads are hashed
+} hash_worker;
+
+// Bounded pool of hashing workers fed from a job queue
+
+typedef struct hash_pool {
+	GAsyncQueue *todo; // Jobs waiting for a worker
+	GAsyncQueue *done; // Jobs waiting to be committed on the scan thread
+	GThread *threads[MAX_HASH_THREADS];
+	int n_threads;
+	int cancel; // Set from the scan thread when a cancel is seen
+	scan_progress *progress; // Scan counters shared with the workers
+	int algo; // Hash engine for every job
+	gboolean drop_cache; // Workers drop hashed pages from the page cache
+} hash_pool;
+
+// Hash cache file header, followed by the slots
+
+typedef struct cache_head {
+	uint64_t magic;
+	uint64_t cap; // Slot count, a power of two
+	uint64_t count; // Slots in use
+	uint64_t algo; // Hash engine the digests came from
+} cache_head;
+
+// One hash cache slot, a size of 0 marks it free since empty files are never hashed
+
+typedef struct cache_rec {
+	uint64_t dev;
+	uint64_t ino;
+	uint64_t size;
+	int64_t mtime_ns;
+	unsigned char digest[SHA256_DIGEST_LENGTH];
+} cache_rec;
+
+// Open hash cache, the whole file is mapped and locked while a scan uses it
+
+typedef struct hash_cache {
+	int fd;
+	cache_head *head;
+	cache_rec *recs;
+	size_t map_len;
+} hash_cache;
+
+// Sort of a model's order, compares the records the positions point at
+
+typedef struct model_sort {
+	GArray *recs;
+	GCompareDataFunc cmp;
+	gpointer data;
+} model_sort;
+
+// A scan running off the main thread
+// - Owns the records until the finalize hands them and their order to the store
+
+typedef struct scan_state {
+	GArray *recs; // Records in walk order
+	GArray *order; // Positions to show, set by the finalize
+	char *stop; // Why the scan stopped itself, shown back on the main thread
+	int algo; // Hash engine, fixed when the scan starts
+	gboolean drop_cache; // Page cache mode, fixed when the scan starts
+	gboolean verify; // Compare candidates byte for byte in place of the full hash, fixed when the scan starts
+	gboolean include_hidden; // Include options, fixed when the scan starts since the options window can change them
+	gboolean include_directory;
+	gboolean include_empty;
+	gboolean include_duplicate;
+	gboolean include_unique;
+	uint32_t repeats; // Files dropped for being reached more than once
+	int pulsed; // Entries walked at the last pulse, main thread only
+	int64_t started; // Frame time hashing was first seen, main thread only
+	int64_t shown; // Frame time of the last text update, main thread only
+	scan_progress progress;
+} scan_state;
+
 // Use when searching columns
 
 typedef struct search_entry {
@@ -135,9 +552,13 @@ typedef struct user_data {
 	GtkWidget *column_view;
 
 	// Entry data
-	GListStore *list_store;
-	GListStore *filtered_list_store;
-	GListStore *org_list_store;
+	DupModel *list_store;
+	DupModel *filtered_list_store;
+	DupModel *org_list_store;
+	GPtrArray *dirs; // Interned directory paths shared by the stored items
+	GPtrArray *arenas; // Name arenas the stored items point into, freed at once by clear_stores
+	group_totals totals; // Set by get_results
+	scan_state *scan; // Not NULL while a scan runs
 
 	// Buttons - need to adjust sensivity
 	GtkWidget *sort_button;
@@ -152,7 +573,7 @@ typedef struct user_data {
 	char **fdpp; // A pointer to an array of pointers to folder names
 
 	// Selection processing fields
-	DupItem *sel_item;
+	dup_rec *sel_item;
 	uint32_t sel_item_position;
         GtkMultiSelection *selection;
 	GtkBitset *sel_bitset;
@@ -204,6 +625,9 @@ typedef struct user_data {
 	unsigned char opt_preserve;
         gboolean opt_manual_prompt;
         gboolean opt_auto_prompt;
+	unsigned char opt_hash; // Hash engine
+	gboolean opt_drop_cache; // Hash without filling the page cache
+	gboolean opt_verify; // Verify duplicates byte for byte
 
 } user_data;
 
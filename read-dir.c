@@ -0,0 +1,84 @@
+// This file, read-dir.c, is a part of the Dedupe Entries program.
+// 
+// Copyright (C) 2025  David Hugh
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https:www.gnu.org/licenses/>.
+
+#include "main.h"
+#include <sys/syscall.h>
+#include "read-dir.h"
+
+// Kernel record layout returned by getdents64
+
+struct linux_dirent64 {
+	uint64_t d_ino;
+	int64_t d_off;
+	unsigned short d_reclen;
+	unsigned char d_type;
+	char d_name[];
+};
+
+#define DIRENT_MIN_REC 24 // Smallest possible record, bounds the names per batch
+
+// Make a directory reader with a buffer of the given size
+// - Buffer and name array are reused for every directory and batch read
+
+dir_reader *dir_reader_new (size_t size)
+{
+	dir_reader *rp = g_malloc0(sizeof(dir_reader));
+	rp->size = MAX(size, 4096);
+	rp->buff = g_malloc(rp->size);
+	rp->names = g_malloc0((rp->size / DIRENT_MIN_REC + 1) * sizeof(dir_name));
+	rp->fd = -1;
+	return rp;
+}
+
+// Point the reader at a directory fd, the caller still owns the fd
+
+void dir_reader_reset (dir_reader *rp, int fd)
+{
+	rp->fd = fd;
+	rp->n_names = 0;
+}
+
+// Read the next batch of names with one getdents64 call
+// - Names point into the reader buffer and are only good until the next call
+// - . and .. are left for the caller, same as readdir
+// - Return the count in the batch, 0 at the end, -1 on error
+
+int dir_reader_next_batch (dir_reader *rp)
+{
+	rp->n_names = 0;
+	long len = syscall(SYS_getdents64, rp->fd, rp->buff, rp->size);
+	if (len <= 0) return len < 0 ? -1 : 0;
+
+	for (long pos = 0; pos < len;) {
+		struct linux_dirent64 *dp = (struct linux_dirent64 *) (rp->buff + pos);
+		dir_name *np = &rp->names[rp->n_names++];
+		np->name = dp->d_name;
+		np->ino = dp->d_ino;
+		np->type = dp->d_type;
+		pos += dp->d_reclen;
+	}
+	return rp->n_names;
+}
+
+// Free up a directory reader, the fd is not closed
+
+void dir_reader_free (dir_reader *rp)
+{
+	g_free(rp->names);
+	g_free(rp->buff);
+	g_free(rp);
+}
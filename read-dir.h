@@ -0,0 +1,26 @@
+// This file, read-dir.h, is a part of the Dedupe Entries program.
+// 
+// Copyright (C) 2025  David Hugh
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https:www.gnu.org/licenses/>.
+
+#ifndef read_dir_h
+#define read_dir_h
+
+dir_reader *dir_reader_new (size_t);
+void dir_reader_reset (dir_reader *, int);
+int dir_reader_next_batch (dir_reader *);
+void dir_reader_free (dir_reader *);
+
+#endif
@@ -0,0 +1,404 @@
+// This file, read-pipe.c, is a part of the Dedupe Entries program.
+// 
+// Copyright (C) 2025  David Hugh
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https:www.gnu.org/licenses/>.
+
+#define _GNU_SOURCE // For O_NOATIME
+#include "main.h"
+#include "hash-engine.h"
+#include "get-hash.h"
+#include "hash-pool.h"
+#include "read-pipe.h"
+
+static __thread sigjmp_buf *map_jump; // Set while this thread hashes from a mapping
+
+// Catch a fault reading a mapping, the file was truncated under it
+// - Jumps back to the worker hashing the mapping, any other SIGBUS is a real fault and takes the default action
+
+void map_fault (int sig)
+{
+	if (map_jump) siglongjmp(*map_jump, 1);
+	signal(sig, SIG_DFL);
+	raise(sig);
+}
+
+// Install the mapping fault handler, once for the process
+
+void map_fault_init (void)
+{
+	static gsize done = 0;
+	if (g_once_init_enter(&done)) {
+		struct sigaction sa = { 0 };
+		sa.sa_handler = map_fault;
+		sigemptyset(&sa.sa_mask);
+		sigaction(SIGBUS, &sa, NULL);
+		g_once_init_leave(&done, 1);
+	}
+}
+
+// Setup a read pipe
+// - Read buffers are aligned and digest states for the scan's engine created once, then reused for every file
+// - Uses io_uring when built with it and the kernel allows, otherwise plain pread
+
+read_pipe *read_pipe_new (int algo, gboolean drop_cache)
+{
+	read_pipe *rp = g_malloc0(sizeof(read_pipe));
+	rp->drop_cache = drop_cache;
+	map_fault_init();
+	for (int i = 0; i < PIPE_DEPTH; i++) rp->slots[i].buff = g_aligned_alloc(1, PIPE_CHUNK, PIPE_ALIGN);
+	for (int i = 0; i < PIPE_FILES; i++) {
+		rp->streams[i].hctx = hash_ctx_new(algo);
+		rp->streams[i].fd = -1;
+	}
+#ifdef HAVE_LIBURING
+	rp->uring = (io_uring_queue_init(PIPE_DEPTH, &rp->ring, 0) == 0);
+#endif
+	return rp;
+}
+
+// Free up a read pipe
+
+void read_pipe_free (read_pipe *rp)
+{
+#ifdef HAVE_LIBURING
+	if (rp->uring) io_uring_queue_exit(&rp->ring);
+#endif
+	for (int i = 0; i < PIPE_DEPTH; i++) g_aligned_free(rp->slots[i].buff);
+	for (int i = 0; i < PIPE_FILES; i++) hash_ctx_free(rp->streams[i].hctx);
+	g_free(rp);
+}
+
+// Check the open file is on a local disk filesystem
+// - Network, fuse and pseudo filesystems can change or vanish under a mapping, so they stay on the read pipe
+
+gboolean map_local (int fd)
+{
+	struct statfs fs;
+	if (fstatfs(fd, &fs) < 0) return FALSE;
+
+	switch ((unsigned long) fs.f_type) {
+	case EXT4_SUPER_MAGIC: // Also ext2 and ext3
+	case XFS_SUPER_MAGIC:
+	case BTRFS_SUPER_MAGIC:
+	case F2FS_SUPER_MAGIC:
+	case TMPFS_MAGIC:
+	case SQUASHFS_MAGIC:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+// Hash a large range straight from a mapping of the file
+// - Saves the copy into a read buffer, the kernel reads ahead because of MADV_SEQUENTIAL
+// - Pages already hashed are dropped with MADV_DONTNEED so a multi-GB file doesn't pile up in the worker
+// - In drop cache mode they are then dropped from the page cache too, once unmapped the kernel can let them go
+// - A file truncated while mapped faults on the missing pages, the fault jumps back here and fails the job
+// - Return 0 to fall back to the read pipe (file not local, shorter than expected, or the map failed), otherwise 1
+
+int map_stream (pipe_stream *ps, hash_worker *wp, uint64_t start, uint64_t len)
+{
+	struct stat st;
+	if (!map_local(ps->fd)) return 0;
+	if (fstat(ps->fd, &st) < 0 || (uint64_t) st.st_size < start + len) return 0; // Let the pipe find the short read
+
+	uint64_t page = sysconf(_SC_PAGESIZE);
+	uint64_t base = start & ~(page - 1);
+	size_t size = start + len - base;
+	unsigned char *map = mmap(NULL, size, PROT_READ, MAP_SHARED, ps->fd, base);
+	if (map == MAP_FAILED) return 0;
+	madvise(map, size, MADV_SEQUENTIAL);
+
+	sigjmp_buf jump;
+	if (sigsetjmp(jump, 1)) {
+		map_jump = NULL;
+		ps->jp->error = "Error: file changed while hashing";
+		munmap(map, size);
+		return 1;
+	}
+	map_jump = &jump;
+
+	size_t done = start - base, dropped = 0;
+	while (done < size) {
+		if (g_atomic_int_get(wp->cancel)) {
+			ps->jp->error = "Error: Hash Canceled";
+			break;
+		}
+		size_t n = MIN(MAP_WINDOW, size - done);
+		if (!hash_ctx_update(ps->hctx, map + done, n)) {
+			ps->jp->error = "Error: Digest update issue";
+			break;
+		}
+		done += n;
+		g_atomic_pointer_add(&wp->progress->bytes, n);
+
+		size_t behind = done & ~(page - 1);
+		madvise(map + dropped, behind - dropped, MADV_DONTNEED);
+		if (wp->pipe->drop_cache) posix_fadvise(ps->fd, base + dropped, behind - dropped, POSIX_FADV_DONTNEED);
+		dropped = behind;
+	}
+	map_jump = NULL;
+	munmap(map, size);
+	return 1;
+}
+
+// Open a file to hash without updating its access time
+// - O_NOATIME is only allowed on files the user owns, so fall back to a plain open on EPERM
+
+int open_noatime (const char *name)
+{
+	int fd = open(name, O_RDONLY | O_CLOEXEC | O_NOATIME);
+	if (fd < 0 && errno == EPERM) fd = open(name, O_RDONLY | O_CLOEXEC);
+	return fd;
+}
+
+// Start a job on a free stream
+// - Ranges of MAP_MIN or more are hashed right here from a mapping when the filesystem allows
+// - Return 0 if the job is already finished (failed, or hashed from a mapping), otherwise return 1
+
+int start_stream (read_pipe *rp, hash_worker *wp, int s, hash_job *jp)
+{
+	pipe_stream *ps = &rp->streams[s];
+	uint64_t start, len;
+
+	if (g_atomic_int_get(wp->cancel)) {
+		jp->error = "Error: Hash Canceled";
+		return 0;
+	}
+
+	ps->fd = open_noatime(jp->name);
+	if (ps->fd < 0) {
+		jp->error = "Error: file read failure";
+		return 0;
+	}
+	if (!job_digest_init(jp, ps->hctx)) {
+		close(ps->fd);
+		ps->fd = -1;
+		return 0;
+	}
+
+	job_range(jp, &start, &len);
+	ps->jp = jp;
+	if (len >= MAP_MIN && map_stream(ps, wp, start, len)) {
+		if (!jp->error) job_digest_final(jp, ps->hctx);
+		close(ps->fd);
+		ps->fd = -1;
+		ps->jp = NULL;
+		return 0;
+	}
+	ps->next_read = start;
+	ps->next_hash = start;
+	ps->end = start + len;
+	ps->in_flight = 0;
+	return 1;
+}
+
+// Fill the free streams with jobs
+// - First job is the one the worker already took, the rest are taken only if ready without waiting
+// - Jobs that fail to start, or were hashed from a mapping, go straight back to the scan thread
+
+void fill_streams (read_pipe *rp, hash_worker *wp, hash_job **first, hash_pool *pool)
+{
+	for (int s = 0; s < PIPE_FILES; s++) {
+		while (!rp->streams[s].jp) {
+			hash_job *jp = *first ? *first : hash_pool_try_next(pool);
+			*first = NULL;
+			if (!jp) return;
+			if (!start_stream(rp, wp, s, jp)) g_async_queue_push(pool->done, jp);
+		}
+	}
+}
+
+// Put a read in a free slot
+// - With io_uring the read is only prepared, pread completes it right away
+
+void submit_read (read_pipe *rp, int slot, int s)
+{
+	pipe_slot *sp = &rp->slots[slot];
+	pipe_stream *ps = &rp->streams[s];
+
+	sp->stream = s;
+	sp->offset = ps->next_read;
+	sp->len = MIN(PIPE_CHUNK, ps->end - ps->next_read);
+	sp->state = SLOT_BUSY;
+	ps->next_read += sp->len;
+	ps->in_flight++;
+	rp->busy++;
+
+#ifdef HAVE_LIBURING
+	if (rp->uring) {
+		struct io_uring_sqe *sqe = io_uring_get_sqe(&rp->ring); // Never more than PIPE_DEPTH busy, so never NULL
+		io_uring_prep_read(sqe, ps->fd, sp->buff, sp->len, sp->offset);
+		io_uring_sqe_set_data(sqe, sp);
+		rp->queued++;
+		return;
+	}
+#endif
+	sp->res = pread(ps->fd, sp->buff, sp->len, sp->offset);
+	sp->state = SLOT_DONE;
+	rp->busy--;
+}
+
+// Submit reads into every free slot
+// - Streams take turns, each capped so one large file can't hold every slot
+
+void submit_reads (read_pipe *rp)
+{
+	for (int slot = 0; slot < PIPE_DEPTH; slot++) {
+		if (rp->slots[slot].state != SLOT_FREE) continue;
+
+		int s = -1;
+		for (int i = 0; i < PIPE_FILES; i++) {
+			int next = (rp->next_stream + i) % PIPE_FILES;
+			pipe_stream *ps = &rp->streams[next];
+			if (ps->jp && ps->next_read < ps->end && ps->in_flight < PIPE_PER_FILE) {
+				s = next;
+				break;
+			}
+		}
+		if (s < 0) return; // Nothing left to read right now
+		rp->next_stream = (s + 1) % PIPE_FILES;
+		submit_read(rp, slot, s);
+	}
+}
+
+// Wait for at least one read in flight to finish, only needed with io_uring
+
+void reap_reads (read_pipe *rp)
+{
+#ifdef HAVE_LIBURING
+	if (!rp->uring) return;
+	if (rp->queued) {
+		io_uring_submit(&rp->ring);
+		rp->queued = 0;
+	}
+	if (!rp->busy) return;
+
+	struct io_uring_cqe *cqe = NULL;
+	if (io_uring_wait_cqe(&rp->ring, &cqe) < 0) return; // Interrupted, caller loops
+	do {
+		pipe_slot *sp = io_uring_cqe_get_data(cqe);
+		sp->res = cqe->res; // Negative errno on failure
+		sp->state = SLOT_DONE;
+		rp->busy--;
+		io_uring_cqe_seen(&rp->ring, cqe);
+	} while (io_uring_peek_cqe(&rp->ring, &cqe) == 0);
+#endif
+}
+
+// Feed finished reads to their digests in file order
+// - A read past a stream's end (file shrank or failed) is just released
+// - A file that ends before the range the walk saw fails, so a partial digest is never committed or cached
+// - Hashed bytes go to the scan counters once per read, never per byte or per GUI update
+// - In drop cache mode each read's pages are dropped from the page cache once hashed
+
+void digest_reads (read_pipe *rp, hash_worker *wp)
+{
+	gboolean progress = TRUE;
+	while (progress) {
+		progress = FALSE;
+		for (int slot = 0; slot < PIPE_DEPTH; slot++) {
+			pipe_slot *sp = &rp->slots[slot];
+			if (sp->state != SLOT_DONE) continue;
+
+			pipe_stream *ps = &rp->streams[sp->stream];
+			if (sp->offset >= ps->end) {
+				sp->state = SLOT_FREE;
+				ps->in_flight--;
+				continue;
+			}
+			if (sp->offset != ps->next_hash) continue; // Wait for the earlier read
+
+			// A short read is finished here, still short means the file shrank since the walk
+			while (sp->res > 0 && (size_t) sp->res < sp->len) {
+				ssize_t more = pread(ps->fd, sp->buff + sp->res, sp->len - sp->res, sp->offset + sp->res);
+				if (more <= 0) break;
+				sp->res += more;
+			}
+
+			if (sp->res < 0) {
+				ps->jp->error = "Error: read failure";
+				ps->end = ps->next_hash; // Stop reading
+			}
+			else if ((size_t) sp->res < sp->len) {
+				ps->jp->error = "Error: file changed while hashing"; // Never a digest of part of the file
+				ps->end = ps->next_hash;
+			}
+			else {
+				if (!ps->jp->error && !hash_ctx_update(ps->hctx, sp->buff, sp->res)) {
+					ps->jp->error = "Error: Digest update issue";
+				}
+				if (rp->drop_cache) posix_fadvise(ps->fd, sp->offset, sp->res, POSIX_FADV_DONTNEED);
+				ps->next_hash += sp->res;
+				g_atomic_pointer_add(&wp->progress->bytes, sp->res);
+			}
+			sp->state = SLOT_FREE;
+			ps->in_flight--;
+			progress = TRUE;
+		}
+	}
+}
+
+// Finish any stream that has read and hashed its whole range
+// - The job goes back to the scan thread and the stream is free for another
+
+void finish_streams (read_pipe *rp, hash_pool *pool)
+{
+	for (int s = 0; s < PIPE_FILES; s++) {
+		pipe_stream *ps = &rp->streams[s];
+		if (!ps->jp || ps->in_flight || ps->next_read < ps->end) continue;
+
+		if (!ps->jp->error) job_digest_final(ps->jp, ps->hctx);
+		close(ps->fd);
+		ps->fd = -1;
+		g_async_queue_push(pool->done, ps->jp);
+		ps->jp = NULL;
+	}
+}
+
+// Stop reading for every stream on cancel, reads in flight still have to land
+
+void cancel_streams (read_pipe *rp)
+{
+	for (int s = 0; s < PIPE_FILES; s++) {
+		pipe_stream *ps = &rp->streams[s];
+		if (!ps->jp) continue;
+		ps->jp->error = "Error: Hash Canceled";
+		ps->end = ps->next_read;
+	}
+}
+
+// Hash jobs through the read pipe
+// - Starts with the job the worker took, and keeps taking ready jobs as streams free up
+// - Several files are read at once, so the disk queue stays full while the digests are updated
+// - Returns when no stream is active and no job is ready
+
+void read_pipe_run (read_pipe *rp, hash_worker *wp, hash_job *first, hash_pool *pool)
+{
+	while (TRUE) {
+		fill_streams(rp, wp, &first, pool);
+
+		gboolean active = FALSE;
+		for (int s = 0; s < PIPE_FILES; s++) active |= (rp->streams[s].jp != NULL);
+		if (!active) return;
+
+		if (g_atomic_int_get(wp->cancel)) cancel_streams(rp);
+
+		submit_reads(rp);
+		reap_reads(rp);
+		digest_reads(rp, wp);
+		finish_streams(rp, pool);
+	}
+}
@@ -0,0 +1,26 @@
+// This file, read-pipe.h, is a part of the Dedupe Entries program.
+// 
+// Copyright (C) 2025  David Hugh
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https:www.gnu.org/licenses/>.
+
+#ifndef read_pipe_h
+#define read_pipe_h
+
+read_pipe *read_pipe_new (int, gboolean);
+int open_noatime (const char *);
+void read_pipe_run (read_pipe *, hash_worker *, hash_job *, hash_pool *);
+void read_pipe_free (read_pipe *);
+
+#endif
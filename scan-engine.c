@@ -0,0 +1,213 @@
+// This file, scan-engine.c, is a part of the Dedupe Entries program.
+// 
+// Copyright (C) 2025  David Hugh
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https:www.gnu.org/licenses/>.
+
+#include "main.h"
+#include "dup-model.h"
+#include "traverse.h"
+#include "hash-candidates.h"
+#include "get-results.h"
+#include "load-store.h"
+#include "hash-engine.h"
+#include "lib.h"
+#include "scan-engine.h"
+
+// Add the bytes left, rates and an ETA to the progress text
+// - Measured against the plan, every byte the stages so far read plus what the rest should read
+// - Rates are over all the hashing so far, so sampling and full hashing smooth each other out
+
+void progress_rates (scan_state *sp, int64_t now, char *buff, size_t size)
+{
+	scan_progress *pp = &sp->progress;
+	gsize bytes = (gsize) g_atomic_pointer_get(&pp->bytes);
+	gsize planned = MAX(bytes, (gsize) g_atomic_pointer_get(&pp->planned));
+	double secs = (now - sp->started) / (double) G_USEC_PER_SEC;
+
+	char *left = g_format_size(planned - bytes);
+	size_t used = strlen(buff);
+	snprintf(buff + used, size - used, " - %s remaining", left);
+	g_free(left);
+	if (secs <= 0) return;
+
+	double file_rate = g_atomic_int_get(&pp->files) / secs;
+	double byte_rate = bytes / secs;
+	char *rate = g_format_size((guint64) byte_rate);
+	used = strlen(buff);
+	snprintf(buff + used, size - used, " - %.0f files/s - %s/s", file_rate, rate);
+	g_free(rate);
+
+	if (byte_rate < 1) return; // Nothing read yet, no ETA
+	used = strlen(buff);
+	uint64_t eta = (planned - bytes) / byte_rate;
+	snprintf(buff + used, size - used, " - ETA %lu:%02lu:%02lu", eta / 3600, (eta / 60) % 60, eta % 60);
+}
+
+// Show the scan counters, called by the progress bar's frame clock once per frame
+// - The scan threads only bump counters, so this is the one place scan progress reaches GTK
+// - The bar moves every frame, the text is only rebuilt every PROGRESS_TICK
+// - Stops itself once the scan is gone
+
+gboolean scan_tick_cb (GtkWidget *widget, GdkFrameClock *clock, user_data *udp)
+{
+	char buff[256] = { 0x00 }; // Progress text
+	scan_state *sp = udp->scan;
+	if (!sp) return G_SOURCE_REMOVE;
+
+	scan_progress *pp = &sp->progress;
+	int64_t now = gdk_frame_clock_get_frame_time(clock);
+	int phase = g_atomic_int_get(&pp->phase);
+	int found = g_atomic_int_get(&pp->found);
+
+	// Bar, pulse while walking, then the share of the planned bytes read
+	if (phase == SP_WALK) {
+		if (found != sp->pulsed) gtk_progress_bar_pulse(GTK_PROGRESS_BAR(widget)); // Only move when entries come in
+		sp->pulsed = found;
+	}
+	else if (phase != SP_GROUP) {
+		if (!sp->started) sp->started = now;
+		gsize planned = (gsize) g_atomic_pointer_get(&pp->planned);
+		gsize bytes = (gsize) g_atomic_pointer_get(&pp->bytes);
+		gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(widget), planned ? MIN(1.0, (double) bytes / planned) : 1.0);
+	}
+
+	if (now - sp->shown < PROGRESS_TICK) return G_SOURCE_CONTINUE;
+	sp->shown = now;
+
+	// Text
+	int done = g_atomic_int_get(&pp->done);
+	int total = g_atomic_int_get(&pp->total);
+	switch (phase) {
+	case SP_WALK: {
+		char *walked = g_format_size((gsize) g_atomic_pointer_get(&pp->walked));
+		snprintf(buff, sizeof(buff), "Scanned %d entries - %s", found, walked);
+		g_free(walked);
+		break;
+	}
+	case SP_SAMPLE:
+		snprintf(buff, sizeof(buff), "Sampling stage %d of %d: %d of %d files",
+			 g_atomic_int_get(&pp->stage) + 1, PS_N, done, total);
+		progress_rates(sp, now, buff, sizeof(buff));
+		break;
+	case SP_HASH:
+		snprintf(buff, sizeof(buff), "Hashing: %d of %d files", done, total);
+		progress_rates(sp, now, buff, sizeof(buff));
+		break;
+	case SP_VERIFY:
+		snprintf(buff, sizeof(buff), "Verifying: %d of %d groups", done, total);
+		progress_rates(sp, now, buff, sizeof(buff));
+		break;
+	default:
+		snprintf(buff, sizeof(buff), "Grouping %d entries", found);
+		break;
+	}
+	gtk_progress_bar_set_text(GTK_PROGRESS_BAR(widget), buff);
+	return G_SOURCE_CONTINUE;
+}
+
+// Scan thread
+// - Walk, hash the candidates, group and order the records
+// - Works only on the scan's own records and counters, never on the store or GTK
+
+void scan_thread (GTask *task, gpointer source, user_data *udp, GCancellable *cancellable)
+{
+	int rcode = traverse(udp->fdpp, udp); // 1 is good, 0 is a show stopper
+
+	// Sizes are known for all folders, so hash only the candidates and then get results
+	if (rcode) rcode = hash_candidates(udp);
+	if (rcode) rcode = get_results(udp);
+	if (rcode) finalize_store(udp);
+
+	g_task_return_int(task, rcode);
+}
+
+// Free up a finished scan, the store keeps its own references to the records and order
+
+void free_scan (scan_state *sp)
+{
+	g_array_unref(sp->recs);
+	if (sp->order) g_array_unref(sp->order);
+	g_free(sp->stop);
+	g_free(sp);
+}
+
+// Scan finished, back on the main thread
+// - Publish the records to the store in one splice and go on to show them
+// - A cancel or a stop throws the partial scan away
+
+void scan_done_cb (GObject *source, GAsyncResult *res, user_data *udp)
+{
+	scan_state *sp = udp->scan;
+	int rcode = g_task_propagate_int(G_TASK(res), NULL);
+	udp->scan = NULL;
+
+	if (sp->stop) {
+		GtkAlertDialog *alert = gtk_alert_dialog_new("%s", sp->stop);
+		gtk_alert_dialog_show(alert, GTK_WINDOW(udp->main_window));
+		g_object_unref(alert);
+	}
+	int algo = sp->algo;
+	gboolean drop_cache = sp->drop_cache;
+	gboolean verified = sp->verify;
+	if (rcode == 1) dup_model_set(udp->list_store, sp->recs, sp->order);
+	free_scan(sp);
+
+	if (rcode != 1) {
+		cancel_clean_up(udp);
+		return;
+	}
+	g_atomic_int_set(&udp->cancel_request, FALSE); // A late cancel missed the scan
+	udp->totals.algo = algo;
+	udp->totals.drop_cache = drop_cache;
+	udp->totals.verified = verified;
+	show_group_totals(udp);
+	show_entry_data(udp);
+}
+
+// Start a scan of the selected folders off the main thread
+// - Progress comes from a tick on the progress bar, the result from scan_done_cb
+
+void start_scan (user_data *udp)
+{
+	scan_state *sp = g_malloc0(sizeof(scan_state));
+	sp->recs = g_array_new(FALSE, TRUE, sizeof(dup_rec)); // Cleared so new records start zeroed
+	sp->algo = hash_algo_built(udp->opt_hash) ? udp->opt_hash : HA_SHA256; // Options can change while the scan runs
+	sp->drop_cache = udp->opt_drop_cache;
+	sp->verify = udp->opt_verify;
+	sp->include_hidden = udp->opt_include_hidden;
+	sp->include_directory = udp->opt_include_directory;
+	sp->include_empty = udp->opt_include_empty;
+	sp->include_duplicate = udp->opt_include_duplicate;
+	sp->include_unique = udp->opt_include_unique;
+	udp->scan = sp;
+	g_atomic_int_set(&udp->cancel_request, FALSE);
+
+	gtk_widget_add_tick_callback(udp->progress_bar, (GtkTickCallback) scan_tick_cb, udp, NULL);
+
+	GTask *task = g_task_new(NULL, NULL, (GAsyncReadyCallback) scan_done_cb, udp);
+	g_task_set_task_data(task, udp, NULL);
+	g_task_run_in_thread(task, (GTaskThreadFunc) scan_thread);
+	g_object_unref(task);
+}
+
+// Cancel any running scan and wait for it to finish
+// - Used when the main window closes, so the scan never outlives the data it points into
+
+void stop_scan (user_data *udp)
+{
+	if (!udp->scan) return;
+	g_atomic_int_set(&udp->cancel_request, TRUE);
+	while (udp->scan) g_main_context_iteration(NULL, TRUE);
+}
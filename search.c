@@ -16,6 +16,8 @@
 // along with this program.  If not, see <https:www.gnu.org/licenses/>.
 
 #include "main.h"
+#include "dup-model.h"
+#include "lib.h"
 #include "search.h"
 
 // Process choice for search next or cancel prompt
@@ -34,7 +36,7 @@ void work_next_choice (GObject *source_object, GAsyncResult *res, void *ptr)
 	}
 	else { // No next check
 		// Scroll to next check if not at end or top row
-		if (udp->next_check < g_list_model_get_n_items(G_LIST_MODEL(udp->list_store)))
+		if (udp->next_check < dup_model_n(udp->list_store))
 			gtk_column_view_scroll_to(GTK_COLUMN_VIEW(udp->column_view),
 						  udp->next_check, NULL, GTK_LIST_SCROLL_NONE, NULL);
 		else
@@ -70,18 +72,17 @@ void prompt_next (user_data *udp)
 // - Returns index of match or end of list
 // - If target text is substring of name or results then a match
 
-uint32_t search_match_loop (GListStore *list_store, uint32_t cnt, uint32_t *next_check, const char *text)
+uint32_t search_match_loop (DupModel *list_store, uint32_t cnt, uint32_t *next_check, const char *text, user_data *udp)
 {
+	char buff[STR_RESULT] = { 0x00 };
+	char path[STR_PATH] = { 0x00 };
 	uint32_t i = *next_check;
-	DupItem *item = g_object_new(DUP_TYPE_ITEM, NULL);
 	for (; i < cnt; i++) {
-		item = g_list_model_get_item(G_LIST_MODEL(list_store), i);
-		if (strstr(item->result, text) || strstr(item->name, text)) {
+		dup_rec *item = dup_model_rec(list_store, i);
+		if (strstr(item_result_text(item, buff, sizeof(buff)), text) || strstr(item_path(item, udp, path), text)) {
 			*next_check = i + 1;
-			g_object_unref(item);
 			break;
 		}
-		g_object_unref(item);
 	}
 	return i;
 }
@@ -106,11 +107,11 @@ void work_search_entry_cb (GtkWidget *self, user_data *udp)
 	if (!strlen(text)) return; // Bug out if search text is 0 length
 
 	// Get number of items in list store
-	uint32_t cnt = g_list_model_get_n_items(G_LIST_MODEL(udp->list_store));
+	uint32_t cnt = dup_model_n(udp->list_store);
 	if (!cnt) return; // Bug out if list_store is empty
 
 	// Loop through list store and find match
-	uint32_t i = search_match_loop (udp->list_store, cnt, &udp->next_check, text);
+	uint32_t i = search_match_loop (udp->list_store, cnt, &udp->next_check, text, udp);
 
 	if (udp->next_check == 0 && i == cnt) { // Did not find a match
 		GtkAlertDialog *alert = gtk_alert_dialog_new("No match found");
@@ -16,15 +16,11 @@
 // along with this program.  If not, see <https:www.gnu.org/licenses/>.
 
 #include "main.h"
+#include "dup-model.h"
+#include "lib.h"
 #include "work-selected.h"
 #include "show-columns.h"
 
-// Return ptr to name
-static const char *dup_item_get_name(DupItem *item)
-{
-	return item->name;
-}
-
 // Setup the label for the cell, set alignment to left
 static void setup_cb(GtkSignalListItemFactory *factory, GObject *listitem)
 {
@@ -34,21 +30,23 @@ static void setup_cb(GtkSignalListItemFactory *factory, GObject *listitem)
 }
 
 // For the factory, get the result for the item into the label
-// - Bind_property is used to bind the result to the label as may make changes after initial setup
+// - Result text is formatted here, only for rows being shown
 static void bind_result_cb(GtkSignalListItemFactory *factory, GtkListItem *listitem, user_data *udp)
 {
+	char buff[STR_RESULT] = { 0x00 };
 	GtkWidget *label = gtk_list_item_get_child(listitem);
 	GObject *item = gtk_list_item_get_item(GTK_LIST_ITEM(listitem));
-	g_object_bind_property(item, "result", label, "label", G_BINDING_SYNC_CREATE);
+	gtk_label_set_text(GTK_LABEL(label), item_result_text(dup_item_rec(DUP_ITEM(item)), buff, sizeof(buff)));
 }
 
 // For the factory, get the fullname for the item into the label
+// - Full name is joined here from the interned directory and the base name
 static void bind_name_cb(GtkSignalListItemFactory *factory, GtkListItem *listitem, user_data *udp)
 {
+	char path[STR_PATH] = { 0x00 };
 	GtkWidget *label = gtk_list_item_get_child(listitem);
 	GObject *item = gtk_list_item_get_item(GTK_LIST_ITEM(listitem));
-	const char *string = dup_item_get_name(DUP_ITEM(item));
-	gtk_label_set_text(GTK_LABEL(label), string);
+	gtk_label_set_text(GTK_LABEL(label), item_path(dup_item_rec(DUP_ITEM(item)), udp, path));
 }
 
 // Show the column view in the main window
@@ -16,6 +16,8 @@
 // along with this program.  If not, see <https:www.gnu.org/licenses/>.
 
 #include "main.h"
+#include "dup-model.h"
+#include "lib.h"
 #include "sort-store.h"
 
 // Comparsion function for sort of name descending
@@ -23,9 +25,9 @@
 
 int cmp_name_d (const void *a, const void *b, user_data *udp)
 {
-	DupItem *item1 = (DupItem *) a;
-	DupItem *item2 = (DupItem *) b;
-	return (strcmp(item2->name, item1->name)); // Item2 before item1 for descending
+	dup_rec *item1 = (dup_rec *) a;
+	dup_rec *item2 = (dup_rec *) b;
+	return cmp_item_name(item2, item1, udp); // Item2 before item1 for descending
 }
 
 // Comparison function for sort of name ascending
@@ -33,19 +35,19 @@ int cmp_name_d (const void *a, const void *b, user_data *udp)
 
 int cmp_name_a (const void *a, const void *b, user_data *udp)
 {
-	DupItem *item1 = (DupItem *) a;
-	DupItem *item2 = (DupItem *) b;
-	return strcmp(item1->name, item2->name);
+	dup_rec *item1 = (dup_rec *) a;
+	dup_rec *item2 = (dup_rec *) b;
+	return cmp_item_name(item1, item2, udp);
 }
 
 // Used for secondary comparison
 // - Item order is reversed at call time for ascending or descending
 
-int cmp_sec (const void *a, const void *b)
+int cmp_sec (const void *a, const void *b, user_data *udp)
 {
-	DupItem *item1 = (DupItem *) a;
-	DupItem *item2 = (DupItem *) b;
-	return strcmp(item1->name, item2->name);
+	dup_rec *item1 = (dup_rec *) a;
+	dup_rec *item2 = (dup_rec *) b;
+	return cmp_item_name(item1, item2, udp);
 }
 
 // Comparison function for sort of result decending
@@ -53,15 +55,15 @@ int cmp_sec (const void *a, const void *b)
 
 int cmp_result_d (const void *a, const void *b, user_data *udp)
 {
-	DupItem *item1 = (DupItem *) a;
-	DupItem *item2 = (DupItem *) b;
-	if (!strcmp(item1->result, item2->result)) {
+	dup_rec *item1 = (dup_rec *) a;
+	dup_rec *item2 = (dup_rec *) b;
+	if (!cmp_result(item1, item2)) {
 		if (gtk_check_button_get_active(GTK_CHECK_BUTTON(udp->name_a_sec_btn)))
-			return cmp_sec(a, b); // Ascending name sort on equal
+			return cmp_sec(a, b, udp); // Ascending name sort on equal
 		else if (gtk_check_button_get_active(GTK_CHECK_BUTTON(udp->name_d_sec_btn)))
-			return cmp_sec(b, a); // Descending name sort on equal
+			return cmp_sec(b, a, udp); // Descending name sort on equal
 	}
-	return strcmp(item2->result, item1->result);
+	return cmp_result(item2, item1);
 }
 
 // Comparison function for sort of result ascending
@@ -69,15 +71,15 @@ int cmp_result_d (const void *a, const void *b, user_data *udp)
 
 int cmp_result_a (const void *a, const void *b, user_data *udp)
 {
-	DupItem *item1 = (DupItem *) a;
-	DupItem *item2 = (DupItem *) b;
-	if (!strcmp(item1->result, item2->result)) {
+	dup_rec *item1 = (dup_rec *) a;
+	dup_rec *item2 = (dup_rec *) b;
+	if (!cmp_result(item1, item2)) {
 		if (gtk_check_button_get_active(GTK_CHECK_BUTTON(udp->name_a_sec_btn)))
-			return cmp_sec(a, b); // Ascending name sort on equal
+			return cmp_sec(a, b, udp); // Ascending name sort on equal
 		else if (gtk_check_button_get_active(GTK_CHECK_BUTTON(udp->name_d_sec_btn)))
-			return cmp_sec(b, a); // Descending name sort on equal
+			return cmp_sec(b, a, udp); // Descending name sort on equal
 	}
-	return strcmp(item1->result, item2->result);
+	return cmp_result(item1, item2);
 }
 
 // Apply the sort
@@ -89,13 +91,13 @@ void apply_sort_cb (GtkCheckButton *button, user_data *udp)
 
 	// Sort the list store
 	if (gtk_check_button_get_active(GTK_CHECK_BUTTON(udp->result_a_button)))
-		g_list_store_sort(udp->list_store, (GCompareDataFunc) cmp_result_a, udp);
+		dup_model_sort(udp->list_store, (GCompareDataFunc) cmp_result_a, udp);
 	else if (gtk_check_button_get_active(GTK_CHECK_BUTTON(udp->result_d_button)))
-		g_list_store_sort(udp->list_store, (GCompareDataFunc) cmp_result_d, udp);
+		dup_model_sort(udp->list_store, (GCompareDataFunc) cmp_result_d, udp);
 	else if (gtk_check_button_get_active(GTK_CHECK_BUTTON(udp->name_a_button)))
-		g_list_store_sort(udp->list_store, (GCompareDataFunc) cmp_name_a, udp);
+		dup_model_sort(udp->list_store, (GCompareDataFunc) cmp_name_a, udp);
 	else if (gtk_check_button_get_active(GTK_CHECK_BUTTON(udp->name_d_button)))
-		g_list_store_sort(udp->list_store, (GCompareDataFunc) cmp_name_d, udp);
+		dup_model_sort(udp->list_store, (GCompareDataFunc) cmp_name_d, udp);
 
 	gtk_column_view_scroll_to(GTK_COLUMN_VIEW(udp->column_view), 1, NULL, GTK_LIST_SCROLL_NONE, NULL);
 }
@@ -0,0 +1,86 @@
+// This file, stat-entry.c, is a part of the Dedupe Entries program.
+// 
+// Copyright (C) 2025  David Hugh
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https:www.gnu.org/licenses/>.
+
+#define _GNU_SOURCE // For statx
+#include "main.h"
+#include <sys/sysmacros.h>
+#include "stat-entry.h"
+
+// Check if a directory fd is on a network or fuse mount
+// - Those are where forcing attribute revalidation costs a round trip per entry
+
+gboolean is_network_fs (int fd)
+{
+	struct statfs sfs;
+	if (fstatfs(fd, &sfs) == -1) return FALSE;
+
+	switch ((uint32_t) sfs.f_type) {
+	case NFS_SUPER_MAGIC:
+	case SMB_SUPER_MAGIC:
+	case CIFS_SUPER_MAGIC:
+	case SMB2_SUPER_MAGIC:
+	case FUSE_SUPER_MAGIC:
+	case CEPH_SUPER_MAGIC:
+	case AFS_SUPER_MAGIC:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+// Get the metadata for an entry relative to its directory fd
+// - Asks statx for only type, size, mtime, inode and link count, device comes back regardless
+// - On network mounts cached attributes are accepted rather than forcing a sync
+// - A statx that can't supply every field asked for is an error, the entry is not trusted
+// - Symlinks are not followed, the type tells the caller what the entry is
+// - Falls back to fstatat where statx is not available
+// - Return 0 if good, -1 on error
+
+int stat_entry (int dir_fd, const char *name, gboolean net, entry_meta *mp)
+{
+#ifdef STATX_TYPE
+	static int no_statx = FALSE; // Set once if the kernel lacks statx
+	if (!g_atomic_int_get(&no_statx)) {
+		struct statx stx;
+		int flags = AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT | (net ? AT_STATX_DONT_SYNC : AT_STATX_SYNC_AS_STAT);
+		unsigned int mask = STATX_TYPE | STATX_SIZE | STATX_MTIME | STATX_INO | STATX_NLINK;
+
+		if (statx(dir_fd, name, flags, mask, &stx) == 0) {
+			if ((stx.stx_mask & mask) != mask) return -1;
+			mp->mode = stx.stx_mode & S_IFMT;
+			mp->size = stx.stx_size;
+			mp->mtime_ns = (int64_t) stx.stx_mtime.tv_sec * 1000000000 + stx.stx_mtime.tv_nsec;
+			mp->dev = makedev(stx.stx_dev_major, stx.stx_dev_minor);
+			mp->ino = stx.stx_ino;
+			mp->nlink = stx.stx_nlink;
+			return 0;
+		}
+		if (errno != ENOSYS) return -1;
+		g_atomic_int_set(&no_statx, TRUE);
+	}
+#endif
+
+	struct stat attr;
+	if (fstatat(dir_fd, name, &attr, AT_SYMLINK_NOFOLLOW) == -1) return -1;
+	mp->mode = attr.st_mode & S_IFMT;
+	mp->size = attr.st_size;
+	mp->mtime_ns = (int64_t) attr.st_mtim.tv_sec * 1000000000 + attr.st_mtim.tv_nsec;
+	mp->dev = attr.st_dev;
+	mp->ino = attr.st_ino;
+	mp->nlink = attr.st_nlink;
+	return 0;
+}
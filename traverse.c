@@ -17,140 +17,357 @@
 
 #include "main.h"
 #include "lib.h"
-#include "get-hash.h"
+#include "stat-entry.h"
+#include "read-dir.h"
 #include "traverse.h"
 
-// Re-entrant traverse and data store of entry information
-// - Check for cancel request and max entries in loops, return if hit
-// - Return of 1 means continue working, 0 means stop
+// Check for a hidden name, . alone is not hidden
+
+gboolean is_hidden (const char *name)
+{
+	return (name[0] == '.' && name[1] != '\0');
+}
+
+// Make a walked entry record for the scan thread
+// - Shares the directory path, the base name is already in the walker's arena
+// - No base name means the entry is the directory itself
+
+walk_entry *new_walk_entry (int kind, char *dir, const char *base, const char *error)
+{
+	walk_entry *ep = g_malloc0(sizeof(walk_entry));
+	ep->kind = kind;
+	ep->dir = g_ref_string_acquire(dir);
+	ep->base = base;
+	ep->error = error;
+	return ep;
+}
+
+// Free up a walked entry record
 
-int traverse (char *dir_str, user_data *udp)
+void free_walk_entry (walk_entry *ep)
 {
-	// Skip hidden directories if requested
-	if (!memcmp(&dir_str[0], &".", 1) && 
-	    memcmp(&dir_str[1], &"\0", 1) &&
-            udp->opt_include_hidden == FALSE) return 1; 
-
-	int rcode = 1; // Return code, 1 is good, 0 is error
-	int res = 0; // Result of stat/lstat		       
-	char full_name[STR_PATH] = { 0x00 }; // Create full names from passed dir and dir entry
-	char buff[100] = { 0x00 }; // Buffer for conversions
-
-	// Attribute and time structures
-	struct stat attr; // Structue for the stat command
-	struct tm *tinfo; // Structure pointer for time
-
-	// Directory structure and pointers
-	struct dirent *entry = NULL; // Directory entry ptr
-	DIR *dir; // Directory ptr
-
-	// Check max entries before storing folder name
-	if (g_list_model_get_n_items(G_LIST_MODEL(udp->list_store)) >= MAX_ENTRIES) {
-		return 0;
+	g_ref_string_release(ep->dir);
+	g_free(ep);
+}
+
+// Make a queued directory, fd is -1 if it has to be opened by path
+
+walk_dir *new_walk_dir (char *path, int fd)
+{
+	walk_dir *dp = g_malloc0(sizeof(walk_dir));
+	dp->path = path;
+	dp->fd = fd;
+	return dp;
+}
+
+// Free up a queued directory that was never read
+
+void free_walk_dir (walk_dir *dp)
+{
+	if (dp->fd >= 0) close(dp->fd);
+	g_ref_string_release(dp->path);
+	g_free(dp);
+}
+
+// Hand a thread's batch of walked entries to the scan thread and start a new one
+
+void flush_batch (walker *wp, GPtrArray **batch)
+{
+	if ((*batch)->len == 0) return;
+	g_async_queue_push(wp->found, *batch);
+	*batch = g_ptr_array_new_with_free_func((GDestroyNotify) free_walk_entry);
+}
+
+// Queue a directory on a walker's own deque
+// - Pending is raised before the push so the walk can't look finished early
+
+void push_dir (walker *wp, int id, walk_dir *dp)
+{
+	g_atomic_int_inc(&wp->pending);
+	g_mutex_lock(&wp->deques[id].lock);
+	g_queue_push_tail(&wp->deques[id].dirs, dp);
+	g_mutex_unlock(&wp->deques[id].lock);
+}
+
+// Get the next directory to read
+// - Own deque is worked from the tail, depth first
+// - Other deques are stolen from at the head, where the larger subtrees tend to be
+// - Return NULL if every deque is empty
+
+walk_dir *next_dir (walker *wp, int id)
+{
+	walk_dir *dp = NULL;
+
+	g_mutex_lock(&wp->deques[id].lock);
+	dp = g_queue_pop_tail(&wp->deques[id].dirs);
+	g_mutex_unlock(&wp->deques[id].lock);
+
+	for (int i = 1; !dp && i < wp->n_threads; i++) {
+		walk_deque *victim = &wp->deques[(id + i) % wp->n_threads];
+		g_mutex_lock(&victim->lock);
+		dp = g_queue_pop_head(&victim->dirs);
+		g_mutex_unlock(&victim->lock);
+	}
+	return dp;
+}
+
+// Queue a subdirectory, the path is only built once per directory
+// - Opened relative to its parent while the parent is open, up to a limit on held fds
+
+void queue_subdir (walker *wp, int id, walk_dir *dp, int fd, const char *name)
+{
+	char sub_name[STR_PATH] = { 0x00 };
+
+	// Don't want to add a forward slash if root was the passed directory
+	if (dp->path[strlen(dp->path) - 1] != '/') snprintf(sub_name, sizeof(sub_name), "%s/%s", dp->path, name);
+	else snprintf(sub_name, sizeof(sub_name), "%s%s", dp->path, name);
+
+	int sub_fd = -1;
+	if (g_atomic_int_get(&wp->open_fds) < WALK_MAX_FDS) {
+		sub_fd = openat(fd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if (sub_fd >= 0) g_atomic_int_inc(&wp->open_fds);
 	}
+	push_dir(wp, id, new_walk_dir(g_ref_string_new(sub_name), sub_fd));
+}
+
+// Read one directory
+// - Record the directory itself, its regular files, and queue its subdirectories
+// - Names come in large getdents64 batches, so huge directories take few syscalls
+// - Files are stat'd relative to the directory fd, so no path is rebuilt or re-resolved per entry
+// - Entries the file system reports as DT_UNKNOWN are typed by statx rather than dropped
+// - Runs on a walker thread, never touches the store or GUI
 
-	// Setup directory item
-	DupItem *item =
-	    g_object_new(DUP_TYPE_ITEM, "name", dir_str, "hash", "", "file_size", "", "modified", "", NULL);
-
-	// Open the directory in preparation for loop
-	dir = opendir(dir_str);
-	if (!dir) {
-		// Store the result on bad open
-		g_object_set(item, "result", "Error: can't open directory", NULL);
-		g_list_store_append(udp->list_store, item);
-		g_object_unref(item);
-		return 1;
+void read_dir (walker *wp, int id, walk_dir *dp, dir_reader *rp, GPtrArray **batch)
+{
+	entry_meta meta; // Metadata from statx
+	GStringChunk *names = wp->args[id].names; // Base names kept for the items go here
+
+	// Open the directory, fd may already be held from the parent
+	int fd = dp->fd;
+	dp->fd = -1;
+	if (fd >= 0) g_atomic_int_add(&wp->open_fds, -1);
+	else fd = open(dp->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+	if (fd < 0) {
+		g_ptr_array_add(*batch, new_walk_entry(WE_ERROR, dp->path, NULL, "Error: can't open directory"));
+		return;
 	}
+	g_ptr_array_add(*batch, new_walk_entry(WE_DIR, dp->path, NULL, NULL));
 
-	// Store the result on good open
-	g_object_set(item, "result", STR_DIR, NULL);
-	g_list_store_append(udp->list_store, item);
-	g_object_unref(item);
-
-	// Loop through the directory and store the files - recurse when hit a directory
-	while ((entry = readdir(dir))) {
-
-		// Skip ., .., and hidden files (if not requested)
-		if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
-
-		// Skip hidden files and directories if requested
-		if (!memcmp(&entry->d_name[0], &".", 1) && 
-		    memcmp(&entry->d_name[1], &"\0", 1) &&
-                    udp->opt_include_hidden == FALSE) continue; 
-
-		// Don't want to add a forward slash if root was the passed directory
-		if (dir_str[strlen(dir_str) - 1] != '/') snprintf(full_name, sizeof(full_name), "%s/%s", dir_str, entry->d_name);
-		else snprintf(full_name, sizeof(full_name), "%s%s", dir_str, entry->d_name);
-
-		// If the entry is a directory, recurse
-		if (entry->d_type == DT_DIR) {
-			// If return from lower level is 0, then pass 0 back up
-			if (!traverse(full_name, udp)) {
-				if (dir) closedir(dir);
-			       	return 0;
-			}	
-		}
+	// Network mounts take cached attributes, checked once per directory
+	gboolean net = is_network_fs(fd);
 
-		// Only working on POSIX regular files and symlinks
-		if (entry->d_type != DT_REG) continue; 
+	// Loop through the batches of names and record the files - queue directories for any walker
+	dir_reader_reset(rp, fd);
+	while (dir_reader_next_batch(rp) > 0 && !g_atomic_int_get(&wp->cancel)) {
+		for (int i = 0; i < rp->n_names; i++) {
+			dir_name *np = &rp->names[i];
 
-		// Check for cancel request and max entries hit before storing file name
-		if (udp->cancel_request == TRUE) { 
-			if (dir) closedir(dir);
-		       	return 0;
-		}
+			// Skip ., .., and hidden files (if not requested)
+			if (strcmp(np->name, ".") == 0 || strcmp(np->name, "..") == 0) continue;
+			if (is_hidden(np->name) && !wp->include_hidden) continue;
 
-		if (g_list_model_get_n_items(G_LIST_MODEL(udp->list_store)) >= MAX_ENTRIES) {
-			g_idle_add((GSourceFunc) cancel_clean_up, udp); // treat as if cancel requested
-			if (dir) closedir(dir);
-			GtkAlertDialog *alert =
-			    gtk_alert_dialog_new("Max entries of %d hit - Pick folders with fewer entries", MAX_ENTRIES);
-			gtk_alert_dialog_show(alert, GTK_WINDOW(udp->main_window));
-			return 0;
+			if (np->type == DT_DIR) {
+				queue_subdir(wp, id, dp, fd, np->name);
+				continue;
+			}
+
+			// Only working on POSIX regular files, unknown types need a stat to tell
+			if (np->type != DT_REG && np->type != DT_UNKNOWN) continue;
+
+			if (stat_entry(fd, np->name, net, &meta) == -1) { // -1 is error on stat
+				g_ptr_array_add(*batch, new_walk_entry(WE_ERROR, dp->path, g_string_chunk_insert(names, np->name),
+									    "Error: stat failed"));
+				continue;
+			}
+
+			if (meta.mode == S_IFDIR) {
+				queue_subdir(wp, id, dp, fd, np->name);
+				continue;
+			}
+			if (meta.mode != S_IFREG) continue;
+
+			walk_entry *ep = new_walk_entry(WE_FILE, dp->path, g_string_chunk_insert(names, np->name), NULL);
+			ep->meta = meta;
+			g_ptr_array_add(*batch, ep);
+
+			if ((*batch)->len >= WALK_BATCH) flush_batch(wp, batch);
 		}
+	}
+	close(fd);
+}
 
-		// Create object to store
-		item = g_object_new(DUP_TYPE_ITEM, "name", full_name, NULL);
+// Walker thread
+// - Take directories from own deque or steal, until nothing is pending anywhere
 
-		// if (udp->opt_follow_symlink == FALSE) res = lstat(full_name, &attr);
-		// else res = stat(full_name, &attr);
-		res = stat(full_name, &attr);
+gpointer walker_thread (walk_arg *ap)
+{
+	walker *wp = ap->wp;
+	GPtrArray *batch = g_ptr_array_new_with_free_func((GDestroyNotify) free_walk_entry);
+	dir_reader *rp = dir_reader_new(DIRENT_BUFF); // One buffer per walker, reused for every directory
 
-		if (res == -1) { // -1 is error on stat/lstat
-			g_object_set(item, "result", "Error: stat failed", "hash", " ", "file_size", "", "modified", "", NULL);
-			g_list_store_append(udp->list_store, item);
-			g_object_unref(item);
+	while (!g_atomic_int_get(&wp->cancel)) {
+		walk_dir *dp = next_dir(wp, ap->id);
+		if (!dp) {
+			if (g_atomic_int_get(&wp->pending) == 0) break; // All walked
+			g_usleep(WALK_IDLE); // Others still reading, may queue more
 			continue;
 		}
+		read_dir(wp, ap->id, dp, rp, &batch);
+		flush_batch(wp, &batch);
+		free_walk_dir(dp);
+		g_atomic_int_add(&wp->pending, -1); // After any subdirectories were queued
+	}
+
+	dir_reader_free(rp);
+	g_ptr_array_unref(batch);
+	g_atomic_int_add(&wp->running, -1);
+	return NULL;
+}
+
+// Get the id of an interned directory, adding it on first sight
+// - Every entry from one directory shares the walker's ref counted path, so the pointer is the key
+// - The table keeps a reference, so the path outlives the walked entries
+
+uint32_t dir_id (GHashTable *dir_ids, GPtrArray *dirs, char *dir)
+{
+	gpointer id;
+	if (g_hash_table_lookup_extended(dir_ids, dir, NULL, &id)) return GPOINTER_TO_UINT(id);
+
+	g_ptr_array_add(dirs, g_ref_string_acquire(dir));
+	g_hash_table_insert(dir_ids, dir, GUINT_TO_POINTER(dirs->len - 1));
+	return dirs->len - 1;
+}
+
+// Make a store record from a walked entry, only called on the scan thread
+// - Stores the directory id and points at the base name in the arena, the full path is only built where needed
+// - Record must be zeroed
+
+void make_item (walk_entry *ep, dup_rec *item, GHashTable *dir_ids, GPtrArray *dirs)
+{
+	item->dir = dir_id(dir_ids, dirs, ep->dir);
+	item->name = ep->base;
+
+	if (ep->kind == WE_DIR) {
+		item->kind = RK_DIR;
+		return;
+	}
+	if (ep->kind == WE_ERROR) {
+		item->kind = RK_ERROR;
+		item->error = ep->error;
+		return;
+	}
 
+	// Raw metadata only, size and modified text are formatted when shown
+	item->size = ep->meta.size;
+	item->mtime_ns = ep->meta.mtime_ns;
+	item->dev = ep->meta.dev;
+	item->ino = ep->meta.ino;
+	item->nlink = ep->meta.nlink;
 
-		// Get file size in Bytes
-		snprintf(buff, sizeof(buff), "%lu", attr.st_size);
-		g_object_set(item, "file_size", buff, NULL);
+	// Leave result unset for non-empty files, hash_candidates decides if a hash is needed
+	// - Files reached more than once, hardlinks or not, are sorted out there too
+	if (ep->meta.size == 0) item->kind = RK_EMPTY;
+}
+
+// Stop the walker threads and free up the walker
+// - Hands the name arenas over rather than freeing them
+
+void free_walker (walker *wp, GPtrArray *arenas)
+{
+	g_atomic_int_set(&wp->cancel, TRUE);
+	for (int i = 0; i < wp->n_threads; i++) g_thread_join(wp->threads[i]);
+
+	// Name arenas now belong to the scan, the stored items point into them
+	for (int i = 0; i < wp->n_threads; i++) g_ptr_array_add(arenas, wp->args[i].names);
+
+	// Drop anything not taken by the scan thread
+	GPtrArray *batch;
+	while ((batch = g_async_queue_try_pop(wp->found))) g_ptr_array_unref(batch);
+	for (int i = 0; i < wp->n_threads; i++) {
+		g_queue_clear_full(&wp->deques[i].dirs, (GDestroyNotify) free_walk_dir);
+		g_mutex_clear(&wp->deques[i].lock);
+	}
+	g_async_queue_unref(wp->found);
+	g_free(wp);
+}
+
+// Traverse the selected folders and store entry information
+// - Walker threads share the directories with work stealing, so wide and deep trees both spread out
+// - Walked entries come back through a queue and are stored here on the scan thread, the GUI is never touched
+// - Only gathers metadata, hashing is left to hash_candidates once all sizes are known
+// - Check for cancel request and max entries, return if hit
+// - Return of 1 means continue working, 0 means stop
+
+int traverse (char **fdpp, user_data *udp)
+{
+	int rcode = 1;
+	GHashTable *dir_ids = g_hash_table_new(g_direct_hash, g_direct_equal); // Interned directory path to id
+	if (!udp->dirs) udp->dirs = g_ptr_array_new_with_free_func((GDestroyNotify) g_ref_string_release);
+	if (!udp->arenas) udp->arenas = g_ptr_array_new_with_free_func((GDestroyNotify) g_string_chunk_free);
+
+	// Setup the walker and threads
+	walker *wp = g_malloc0(sizeof(walker));
+	wp->found = g_async_queue_new();
+	wp->include_hidden = udp->scan->include_hidden;
+	wp->n_threads = MIN(MAX_WALK_THREADS, MAX(1, g_get_num_processors()));
+	for (int i = 0; i < wp->n_threads; i++) {
+		g_mutex_init(&wp->deques[i].lock);
+		g_queue_init(&wp->deques[i].dirs);
+	}
 
-		// Convert to local time, and then to a string
-		tinfo = localtime(&attr.st_mtim.tv_sec);
-		strftime(buff, sizeof(buff), "%F %H:%M:%S", tinfo);
-		g_object_set(item, "modified", buff, NULL);
+	// Seed the deques with the folders, skip hidden folders if requested
+	for (int i = 0; fdpp[i]; i++) {
+		if (is_hidden(fdpp[i]) && udp->scan->include_hidden == FALSE) continue;
+		push_dir(wp, i % wp->n_threads, new_walk_dir(g_ref_string_new(fdpp[i]), -1));
+	}
+
+	wp->running = wp->n_threads;
+	for (int i = 0; i < wp->n_threads; i++) {
+		wp->args[i].wp = wp;
+		wp->args[i].id = i;
+		wp->args[i].names = g_string_chunk_new(NAME_ARENA);
+		wp->threads[i] = g_thread_new("walk", (GThreadFunc) walker_thread, &wp->args[i]);
+	}
 
-		// Get the hash into item and record any error in result
-		if (attr.st_size != 0) {
-			rcode = getsha256(item, udp); // Will store hex digits representing hash in item
-			g_list_store_append(udp->list_store, item);
-			g_object_unref(item);
+	// Store walked entries until the walkers are done and the queue is drained
+	GArray *recs = udp->scan->recs;
+	while (TRUE) {
+		GPtrArray *batch = g_async_queue_timeout_pop(wp->found, WALK_WAIT);
+		if (!batch) {
+			if (g_atomic_int_get(&wp->running) == 0 && g_async_queue_length(wp->found) == 0) break;
 		}
 		else {
-			g_object_set(item, "result", STR_EMP, "hash", "", NULL);
-			g_list_store_append(udp->list_store, item);
-			g_object_unref(item);
+			// Check max entries before storing
+			if (recs->len + batch->len > MAX_ENTRIES) {
+				g_ptr_array_unref(batch);
+				udp->scan->stop = g_strdup_printf("Max entries of %d hit - Pick folders with fewer entries", MAX_ENTRIES);
+				rcode = 0;
+				break;
+			}
+
+			// Store the batch in one append
+			uint32_t first = recs->len;
+			gsize bytes = 0;
+			g_array_set_size(recs, first + batch->len);
+			for (uint32_t i = 0; i < batch->len; i++) {
+				dup_rec *item = &g_array_index(recs, dup_rec, first + i);
+				make_item(g_ptr_array_index(batch, i), item, dir_ids, udp->dirs);
+				bytes += item->size;
+			}
+			g_ptr_array_unref(batch);
+			g_atomic_int_set(&udp->scan->progress.found, recs->len);
+			g_atomic_pointer_add(&udp->scan->progress.walked, bytes);
+		}
+
+		// Check for cancel request
+		if (g_atomic_int_get(&udp->cancel_request)) {
+			rcode = 0;
+			break;
 		}
-		if (rcode == 0) {
-			if (dir) closedir(dir);
-			return 0; // Stop if error in hash
-		} 
-	} // End Dir read while   
-
-	if (dir) closedir(dir);
-	return 1;
+	}
+
+	free_walker(wp, udp->arenas);
+	g_hash_table_destroy(dir_ids);
+	return rcode;
 }
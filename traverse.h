@@ -18,6 +18,6 @@
 #ifndef traverse_h
 #define traverse_h
 
-int traverse(char *, user_data *); 
+int traverse(char **, user_data *); 
 
 #endif
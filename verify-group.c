@@ -0,0 +1,214 @@
+// This file, verify-group.c, is a part of the Dedupe Entries program.
+// 
+// Copyright (C) 2025  David Hugh
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https:www.gnu.org/licenses/>.
+
+
+#include "main.h"
+#include "read-pipe.h"
+#include "verify-group.h"
+
+// Hash a chunk a word at a time, only used to find the class a chunk matches
+
+guint chunk_hash (const unsigned char *buff, size_t len)
+{
+	uint64_t h = len;
+	size_t i = 0;
+	for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+		uint64_t word;
+		memcpy(&word, buff + i, sizeof(word));
+		h = (h ^ word) * 0x9E3779B97F4A7C15ULL;
+		h ^= h >> 29;
+	}
+	for (; i < len; i++) h = (h ^ buff[i]) * 0x100000001B3ULL;
+	return (guint) (h ^ (h >> 32));
+}
+
+// Hash a class chunk key
+
+guint rep_hash (const void *key)
+{
+	return ((verify_rep const *) key)->hash;
+}
+
+// Chunks match if they split from the same class and hold the same bytes
+
+gboolean rep_equal (const void *a, const void *b)
+{
+	verify_rep const *rep_a = a;
+	verify_rep const *rep_b = b;
+	return rep_a->parent == rep_b->parent && rep_a->hash == rep_b->hash && rep_a->len == rep_b->len &&
+	       !memcmp(rep_a->buff, rep_b->buff, rep_a->len);
+}
+
+// Work out how many files a verifying worker may keep open between chunks
+// - The soft open file limit, less a reserve for the rest of the app, is shared by all the workers
+
+uint32_t verify_fds (hash_pool *pool)
+{
+	struct rlimit rl;
+	if (getrlimit(RLIMIT_NOFILE, &rl) == -1) return 0;
+	if (rl.rlim_cur == RLIM_INFINITY) return VERIFY_FDS;
+	if (rl.rlim_cur <= VERIFY_RESERVE) return 0;
+	return MIN(VERIFY_FDS, (rl.rlim_cur - VERIFY_RESERVE) / pool->n_threads);
+}
+
+// Read one chunk of a member
+// - The file stays open between chunks while keep is set, otherwise it is closed after the read
+// - Return 1 if read, 0 if the file can't be read or came up short, -1 if no descriptor was free to open it
+
+int read_chunk (const char *name, int *fd, unsigned char *buff, uint64_t offset, size_t len, gboolean keep, gboolean drop_cache)
+{
+	if (*fd < 0) *fd = open_noatime(name);
+	if (*fd < 0) return (errno == EMFILE || errno == ENFILE) ? -1 : 0;
+
+	size_t got = 0;
+	while (got < len) {
+		ssize_t res = pread(*fd, buff + got, len - got, offset + got);
+		if (res <= 0) break;
+		got += res;
+	}
+	if (drop_cache) posix_fadvise(*fd, offset, got, POSIX_FADV_DONTNEED);
+	if (!keep || got != len) {
+		close(*fd);
+		*fd = -1;
+	}
+	return got == len;
+}
+
+// Compare the members of a candidate group byte for byte
+// - Members are the leader and the jobs that follow it, all the same size with matching samples
+// - Every member is read a chunk at a time in step, and its chunk looked up under the class it was in
+// - The first member of a class at a chunk keeps the class, a member that differs from it starts or joins a split class
+// - Only one buffer per distinct chunk is kept, sized to the file when it is smaller than a chunk
+// - A member alone in its class can't be a duplicate and is not read again, the group stops once no class has two
+// - Files stay open between chunks, up to this worker's share of the open file limit
+// - Running out of descriptors closes the held files and reopens every member per chunk, it never fails a member by itself
+// - Each member's key is left as a token for its class, unique to the group, then the leader goes back to the scan thread
+
+void verify_group (hash_worker *wp, hash_job *leader, hash_pool *pool)
+{
+	hash_job *jobs = leader;
+	uint32_t cnt = leader->members;
+	uint64_t size = leader->size;
+	size_t chunk = MIN(size, VERIFY_CHUNK);
+	uint32_t *cls = g_malloc0(cnt * sizeof(uint32_t)); // Class of each member, all start in class 0
+	uint32_t *counts = g_malloc0(cnt * sizeof(uint32_t)); // Members in each class
+	gboolean *kept = g_malloc0(cnt * sizeof(gboolean)); // Class was claimed by its first member at this chunk
+	int *fds = g_malloc(cnt * sizeof(int));
+	verify_rep *reps = g_malloc(cnt * sizeof(verify_rep)); // Distinct chunks at this offset
+	unsigned char **spare = g_malloc0((cnt + 1) * sizeof(unsigned char *)); // Buffers free for the next read
+	GHashTable *table = g_hash_table_new(rep_hash, rep_equal);
+	uint32_t classes = 1;
+	uint32_t held = 0; // Files open between chunks
+	uint32_t budget = verify_fds(pool); // Most files to hold
+	uint32_t free_buffs = 0;
+	gboolean live = TRUE;
+	counts[0] = cnt;
+	for (uint32_t k = 0; k < cnt; k++) fds[k] = -1;
+
+	for (uint64_t offset = 0; offset < size && live; offset += chunk) {
+		size_t len = MIN(chunk, size - offset);
+		uint32_t nreps = 0;
+		memset(kept, 0, classes * sizeof(gboolean));
+
+		for (uint32_t k = 0; k < cnt; k++) {
+			uint32_t c = cls[k];
+			if (jobs[k].error || counts[c] < 2) continue;
+			if (g_atomic_int_get(wp->cancel)) {
+				jobs[k].error = "Error: Hash Canceled";
+				counts[c]--;
+				continue;
+			}
+
+			unsigned char *buff = free_buffs ? spare[--free_buffs] : g_malloc(chunk);
+			gboolean open = (fds[k] >= 0);
+			gboolean keep = offset + len < size && (open || held < budget);
+			int got = read_chunk(jobs[k].name, &fds[k], buff, offset, len, keep, wp->pipe->drop_cache);
+			for (int retry = 0; got < 0 && retry < VERIFY_RETRY; retry++) {
+				// Out of descriptors, hold none from now on, then wait for other workers if that wasn't enough
+				for (uint32_t h = 0; h < cnt; h++) {
+					if (fds[h] >= 0) close(fds[h]);
+					fds[h] = -1;
+				}
+				if (!held) g_usleep(HASH_WAIT);
+				held = 0;
+				budget = 0;
+				open = FALSE;
+				got = read_chunk(jobs[k].name, &fds[k], buff, offset, len, FALSE, wp->pipe->drop_cache);
+			}
+			held += (fds[k] >= 0) - open;
+			if (got != 1) {
+				jobs[k].error = "Error: read failure";
+				counts[c]--;
+				spare[free_buffs++] = buff;
+				continue;
+			}
+			g_atomic_pointer_add(&wp->progress->bytes, len);
+
+			// Find the class for this chunk, or make one keeping the buffer
+			verify_rep key = { c, 0, chunk_hash(buff, len) ^ (c * 0x9E3779B9u), len, buff };
+			verify_rep *rp = g_hash_table_lookup(table, &key);
+			if (rp) spare[free_buffs++] = buff;
+			else {
+				rp = &reps[nreps++];
+				*rp = key;
+				rp->cls = kept[c] ? classes++ : c;
+				kept[c] = TRUE;
+				g_hash_table_add(table, rp);
+			}
+			if (rp->cls != c) {
+				counts[c]--;
+				counts[rp->cls]++;
+				cls[k] = rp->cls;
+			}
+		}
+
+		// Chunk buffers go back for the next offset
+		for (uint32_t r = 0; r < nreps; r++) spare[free_buffs++] = reps[r].buff;
+		g_hash_table_remove_all(table);
+
+		// Members that can no longer match anything let go of their files
+		live = FALSE;
+		for (uint32_t k = 0; k < cnt; k++) {
+			if (counts[cls[k]] > 1 && !jobs[k].error) live = TRUE;
+			else if (fds[k] >= 0) {
+				close(fds[k]);
+				fds[k] = -1;
+				held--;
+			}
+		}
+	}
+
+	// Token is the leader's address, unique in the scan, and the class
+	for (uint32_t k = 0; k < cnt; k++) {
+		if (fds[k] >= 0) close(fds[k]);
+		if (jobs[k].error) continue;
+		memset(jobs[k].key, 0, SHA256_DIGEST_LENGTH);
+		memcpy(jobs[k].key, &leader, sizeof(leader));
+		memcpy(jobs[k].key + sizeof(leader), &cls[k], sizeof(uint32_t));
+		jobs[k].md_len = SHA256_DIGEST_LENGTH;
+	}
+
+	for (uint32_t b = 0; b < free_buffs; b++) g_free(spare[b]);
+	g_hash_table_destroy(table);
+	g_free(spare);
+	g_free(reps);
+	g_free(fds);
+	g_free(kept);
+	g_free(counts);
+	g_free(cls);
+	g_async_queue_push(pool->done, leader);
+}
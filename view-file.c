@@ -97,12 +97,13 @@ void make_line_string (unsigned char *input, int len_in, char *output, int offse
 void read_and_make_strings (user_data *udp)
 {
 	// Make the file object for streaming
-	GFile *file = g_file_new_for_path(udp->sel_item->name);
+	char path[STR_PATH] = { 0x00 };
+	GFile *file = g_file_new_for_path(item_path(udp->sel_item, udp, path));
 
 	// Setup input stream
 	GFileInputStream *in = g_file_read(file, NULL, NULL);
 	if (!in) {
-		GtkAlertDialog *alert = gtk_alert_dialog_new("Can't read file %s\n", udp->sel_item->name);
+		GtkAlertDialog *alert = gtk_alert_dialog_new("Can't read file %s\n", path);
 		gtk_alert_dialog_show(alert, GTK_WINDOW(udp->main_window));
 		return;
 	}
@@ -186,7 +187,7 @@ void view_file (user_data *udp)
 
 	// Setup window and scrolled_window for file view
 	GtkWidget *fview_window = gtk_window_new();
-	gtk_window_set_title(GTK_WINDOW(fview_window), basename((char *)udp->sel_item->name));
+	gtk_window_set_title(GTK_WINDOW(fview_window), udp->sel_item->name); // Only files are viewed, so always a base name
 	gtk_window_set_default_size(GTK_WINDOW(fview_window), 896, 256);
 	GtkWidget *scrolled_window = gtk_scrolled_window_new();
 	gtk_window_set_child(GTK_WINDOW(fview_window), GTK_WIDGET(scrolled_window));
@@ -17,83 +17,84 @@
 
 #include "main.h"
 #include "lib.h"
+#include "dup-model.h"
 #include "work-trash.h"
 #include "work-auto.h"
 
 // Comparison function for sort of result ascending modified time ascending 
 
-int sort_modified_a (const void *a, const void *b)
+int sort_modified_a (const void *a, const void *b, user_data *udp)
 {
-	DupItem *item1 = (DupItem *) a;
-	DupItem *item2 = (DupItem *) b;
-	if (!strcmp(item1->result, item2->result)) // Equal result on primary sort
-		return strcmp(item1->modified, item2->modified); // Ascending modified time sort (oldest first)
+	dup_rec *item1 = (dup_rec *) a;
+	dup_rec *item2 = (dup_rec *) b;
+	if (!cmp_result(item1, item2)) // Equal result on primary sort
+		return (item1->mtime_ns > item2->mtime_ns) - (item1->mtime_ns < item2->mtime_ns); // Ascending modified time sort (oldest first)
 	else
-		return strcmp(item1->result, item2->result);
+		return cmp_result(item1, item2);
 }
 
 // Comparison function for sort of result ascending modified time ascending 
 
-int sort_modified_d (const void *a, const void *b)
+int sort_modified_d (const void *a, const void *b, user_data *udp)
 {
-	DupItem *item1 = (DupItem *) a;
-	DupItem *item2 = (DupItem *) b;
-	if (!strcmp(item1->result, item2->result)) // Equal result on primary sort
-		return strcmp(item2->modified, item1->modified); // Decending modified time sort (oldest first)
+	dup_rec *item1 = (dup_rec *) a;
+	dup_rec *item2 = (dup_rec *) b;
+	if (!cmp_result(item1, item2)) // Equal result on primary sort
+		return (item2->mtime_ns > item1->mtime_ns) - (item2->mtime_ns < item1->mtime_ns); // Decending modified time sort (oldest first)
 	else
-		return strcmp(item1->result, item2->result);
+		return cmp_result(item1, item2);
 }
 
 // Comparison function for sort of result ascending name len ascending 
 
-int sort_name_len_a (const void *a, const void *b)
+int sort_name_len_a (const void *a, const void *b, user_data *udp)
 {
-	DupItem *item1 = (DupItem *) a;
-	DupItem *item2 = (DupItem *) b;
-	if (!strcmp(item1->result, item2->result)) // Equal result on primary sort
-		if (strlen(item1->name) < strlen(item2->name)) return -1; // Descending name str len
-		else if (strlen(item1->name) > strlen(item2->name)) return 1;
+	dup_rec *item1 = (dup_rec *) a;
+	dup_rec *item2 = (dup_rec *) b;
+	if (!cmp_result(item1, item2)) // Equal result on primary sort
+		if (item_path_len(item1, udp) < item_path_len(item2, udp)) return -1; // Descending name str len
+		else if (item_path_len(item1, udp) > item_path_len(item2, udp)) return 1;
 		else return 0;
 	else
-		return strcmp(item1->result, item2->result);
+		return cmp_result(item1, item2);
 }
 
 // Comparison function for sort of result ascending name len descending 
 
-int sort_name_len_d (const void *a, const void *b)
+int sort_name_len_d (const void *a, const void *b, user_data *udp)
 {
-	DupItem *item1 = (DupItem *) a;
-	DupItem *item2 = (DupItem *) b;
-	if (!strcmp(item1->result, item2->result)) // Equal result on primary sort
-		if (strlen(item2->name) < strlen(item1->name)) return -1; // Descending name str len
-		else if (strlen(item2->name) > strlen(item1->name)) return 1;
+	dup_rec *item1 = (dup_rec *) a;
+	dup_rec *item2 = (dup_rec *) b;
+	if (!cmp_result(item1, item2)) // Equal result on primary sort
+		if (item_path_len(item2, udp) < item_path_len(item1, udp)) return -1; // Descending name str len
+		else if (item_path_len(item2, udp) > item_path_len(item1, udp)) return 1;
 		else return 0;
 	else
-		return strcmp(item1->result, item2->result);
+		return cmp_result(item1, item2);
 }
 
 // Comparison function for sort ascending result ascending name  
 
-int sort_name_a (const void *a, const void *b)
+int sort_name_a (const void *a, const void *b, user_data *udp)
 {
-	DupItem *item1 = (DupItem *) a;
-	DupItem *item2 = (DupItem *) b;
-	if (!strcmp(item1->result, item2->result)) // Equal result on primary sort
-		return strcmp(item1->name, item2->name); // Ascending name
+	dup_rec *item1 = (dup_rec *) a;
+	dup_rec *item2 = (dup_rec *) b;
+	if (!cmp_result(item1, item2)) // Equal result on primary sort
+		return cmp_item_name(item1, item2, udp); // Ascending name
 	else
-		return strcmp(item1->result, item2->result);
+		return cmp_result(item1, item2);
 }
 
 // Comparison function for sort ascending result descending name 
 
-int sort_name_d (const void *a, const void *b)
+int sort_name_d (const void *a, const void *b, user_data *udp)
 {
-	DupItem *item1 = (DupItem *) a;
-	DupItem *item2 = (DupItem *) b;
-	if (!strcmp(item1->result, item2->result)) // Equal result on primary sort
-		return strcmp(item2->name, item1->name); // Descending name
+	dup_rec *item1 = (dup_rec *) a;
+	dup_rec *item2 = (dup_rec *) b;
+	if (!cmp_result(item1, item2)) // Equal result on primary sort
+		return cmp_item_name(item2, item1, udp); // Descending name
 	else
-		return strcmp(item1->result, item2->result);
+		return cmp_result(item1, item2);
 }
 
 // Factory setup
@@ -118,33 +119,43 @@ static void bind_auto_list_cb(GtkSignalListItemFactory *self, GtkListItem *listi
 
 // Sort the store based on the option for which members of a group remain or get trashed
 
-void preserve_sort(unsigned char preserve, GListStore *store)
+void preserve_sort(unsigned char preserve, DupModel *store, user_data *udp)
 {
 	// Sort the store based on option for which members of a group remain or get trashed
 	switch (preserve) {
 	case AP_MOD_FIRST:
-		g_list_store_sort(store, (GCompareDataFunc) sort_modified_a, NULL);
+		dup_model_sort(store, (GCompareDataFunc) sort_modified_a, udp);
 		break;
 	case AP_MOD_LAST:
-		g_list_store_sort(store, (GCompareDataFunc) sort_modified_d, NULL);
+		dup_model_sort(store, (GCompareDataFunc) sort_modified_d, udp);
 		break;
 	case AP_SHORTEST:
-		g_list_store_sort(store, (GCompareDataFunc) sort_name_len_a, NULL);
+		dup_model_sort(store, (GCompareDataFunc) sort_name_len_a, udp);
 		break;
 	case AP_LONGEST:
-		g_list_store_sort(store, (GCompareDataFunc) sort_name_len_d, NULL);
+		dup_model_sort(store, (GCompareDataFunc) sort_name_len_d, udp);
 		break;
 	case AP_ASCENDING:
-		g_list_store_sort(store, (GCompareDataFunc) sort_name_a, NULL);
+		dup_model_sort(store, (GCompareDataFunc) sort_name_a, udp);
 		break;
 	case AP_DESCENDING:
-		g_list_store_sort(store, (GCompareDataFunc) sort_name_d, NULL);
+		dup_model_sort(store, (GCompareDataFunc) sort_name_d, udp);
 		break;
 	default:
 		break;
 	}
 }
 
+// Add a trashed item to the reclaim totals
+// - A file with other hardlinks keeps its data on disk, so trashing it frees nothing
+
+void tally_trash (dup_rec *item, uint64_t *bytes, uint32_t *files, uint32_t *linked)
+{
+	(*files)++;
+	if (item->nlink > 1) (*linked)++;
+	else *bytes += item->size;
+}
+
 // Identify the entries to remain or be trashed
 // - The first entry in a group is kept, the other entries are trashed
 // - Hence sort order is key to this function
@@ -153,13 +164,18 @@ void id_remain_trash (user_data *udp)
 {
 	// Strings for the auto view
 	char str[256] = { 0x00 };
-	char group[10] = { 0x00 };
+	char modified[STR_MODIFIED] = { 0x00 };
+	char path[STR_PATH] = { 0x00 };
+	uint32_t group = 0; // Current group, groups number from 1
+	uint64_t bytes = 0; // Reclaim totals
+	uint32_t files = 0;
+	uint32_t linked = 0;
 
 	// Sort to setup loop
-	preserve_sort(udp->opt_preserve, udp->list_store);
+	preserve_sort(udp->opt_preserve, udp->list_store, udp);
 
 	// Setup an interation through the store
-	uint32_t cnt = g_list_model_get_n_items(G_LIST_MODEL(udp->list_store));
+	uint32_t cnt = dup_model_n(udp->list_store);
 	uint32_t i = 0;
 
 
@@ -170,52 +186,54 @@ void id_remain_trash (user_data *udp)
 	for (; i + 1 < cnt; i++) {
 		do_pending(); // Keep the GUI responsive
 		// Get current and next items
-		DupItem *item = g_list_model_get_item(G_LIST_MODEL(udp->list_store), i);
-		DupItem *next_item = g_list_model_get_item(G_LIST_MODEL(udp->list_store), i + 1);
+		dup_rec *item = dup_model_rec(udp->list_store, i);
+		dup_rec *next_item = dup_model_rec(udp->list_store, i + 1);
 
 		// Stop if either are not a group
-		if (!isdigit(item->result[0]) || !isdigit(next_item->result[0])) {
-			g_object_unref(item);
-			g_object_unref(next_item);
+		if (item->kind != RK_GROUP || next_item->kind != RK_GROUP) 
 			break;
-		}
 
 		// If equal then either start or following entries in group
-		if (!strcmp(item->result, next_item->result)) {
-			if (strcmp(item->result, group)) { // 1st in group if not equal
-				snprintf(group, sizeof(group), "%s", item->result); // Use to identify last in group
-				snprintf(str, sizeof(str), "%s - Group %s - Modified %s - Name: %s", "Remain", item->result,
-					 item->modified, item->name);
+		if (item->group == next_item->group) {
+			if (item->group != group) { // 1st in group if not equal
+				group = item->group; // Use to identify last in group
+				snprintf(str, sizeof(str), "%s - Group %07u - Modified %s - Name: %s", "Remain", item->group,
+					 item_modified_text(item, modified, sizeof(modified)), item_path(item, udp, path));
 				gtk_string_list_append(udp->auto_list, str);
 			}
 			else { // Middle of group
 				gtk_bitset_add(udp->sel_bitset, i); // Add to bitset for trashing
-				snprintf(str, sizeof(str), "%s - Group %s - Modified %s - Name: %s", "Trash ", item->result,
-					 item->modified, item->name);
+				tally_trash(item, &bytes, &files, &linked);
+				snprintf(str, sizeof(str), "%s - Group %07u - Modified %s - Name: %s", "Trash ", item->group,
+					 item_modified_text(item, modified, sizeof(modified)), item_path(item, udp, path));
 				gtk_string_list_append(udp->auto_list, str);
 			}
 		}
 		// Must be the last in the group
-		else if (!strcmp(item->result, group)) { // Last in group
+		else if (item->group == group) { // Last in group
 			gtk_bitset_add(udp->sel_bitset, i); // Add to bitset for trashing
-			snprintf(str, sizeof(str), "%s - Group %s - Modified %s - Name: %s", "Trash ", item->result, item->modified,
-				 item->name);
+			tally_trash(item, &bytes, &files, &linked);
+			snprintf(str, sizeof(str), "%s - Group %07u - Modified %s - Name: %s", "Trash ", item->group,
+				 item_modified_text(item, modified, sizeof(modified)), item_path(item, udp, path));
 			gtk_string_list_append(udp->auto_list, str);
 		}
-		g_object_unref(item);
-		g_object_unref(next_item);
 	}
 
 	// Here because only one left or next was not in group
-	DupItem *item = g_list_model_get_item(G_LIST_MODEL(udp->list_store), i);
-	if (!strcmp(item->result, group)) { // Last in group
+	dup_rec *item = dup_model_rec(udp->list_store, i);
+	if (item->kind == RK_GROUP && item->group == group) { // Last in group
 		gtk_bitset_add(udp->sel_bitset, i); // Add to bitset for trashing
-		snprintf(str, sizeof(str), "%s - Group %s - Modified %s - Name: %s", "Trash ", item->result, item->modified,
-			 item->name);
+		tally_trash(item, &bytes, &files, &linked);
+		snprintf(str, sizeof(str), "%s - Group %07u - Modified %s - Name: %s", "Trash ", item->group,
+			 item_modified_text(item, modified, sizeof(modified)), item_path(item, udp, path));
 		gtk_string_list_append(udp->auto_list, str);
 	}
 
-	g_object_unref(item);
+	// Total what trashing frees, hardlinked files only free a name
+	if (linked) snprintf(str, sizeof(str), "Total  - Trash %u files - Reclaim %lu bytes - %u hardlinked files free nothing",
+			     files, bytes, linked);
+	else snprintf(str, sizeof(str), "Total  - Trash %u files - Reclaim %lu bytes", files, bytes);
+	gtk_string_list_append(udp->auto_list, str);
 
 	if (udp->opt_auto_prompt) {
 		prompt_trash(udp);
@@ -234,9 +252,7 @@ void work_auto (user_data *udp)
 	udp->auto_dedupe = FALSE; // Have to reselect auto dedupe
 
 	// If no groups auto pointless throw a message
-	DupItem *item = g_list_model_get_item(G_LIST_MODEL(udp->list_store), 0);
-	if (!isdigit(item->result[0])) { // Default sort puts groups (7 digits) first
-		g_object_unref(item);
+	if (!dup_model_n(udp->list_store) || dup_model_rec(udp->list_store, 0)->kind != RK_GROUP) { // Default sort puts groups first
 		gtk_window_set_child(GTK_WINDOW(udp->main_window), NULL);
 		GtkAlertDialog *alert = gtk_alert_dialog_new("No duplicates found");
 		gtk_alert_dialog_set_modal(GTK_ALERT_DIALOG(alert), TRUE);
@@ -244,7 +260,6 @@ void work_auto (user_data *udp)
 		g_object_unref(alert);
 		return;
 	}
-	g_object_unref(item);
 
 	// Initial string list model
 	udp->auto_list = gtk_string_list_new(NULL);
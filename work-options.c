@@ -18,6 +18,7 @@
 #include "main.h"
 #include "load-store.h"
 #include "lib.h"
+#include "hash-engine.h"
 #include "work-options.h"
 
 // Apply the options changed in memory to the current selected folders
@@ -25,6 +26,7 @@
 void apply_cb(GtkCheckButton *self, user_data *udp)
 {
 	gtk_window_close (GTK_WINDOW (udp->option_window));
+	if (udp->scan) return; // Options apply to the next scan
 	gtk_window_set_child (GTK_WINDOW (udp->main_window), NULL);
 	clear_stores(udp);
 	load_entry_data(udp);
@@ -39,7 +41,7 @@ void save_cb(GtkCheckButton *self, user_data *udp)
         GFileOutputStream *out = g_file_replace (file, NULL, TRUE, G_FILE_CREATE_NONE, NULL, NULL);
 
         // Creat variant from current values
-        GVariant *value = g_variant_new ("(bbbbbybb)", udp->opt_include_hidden, udp->opt_include_directory, udp->opt_include_empty, udp->opt_include_duplicate, udp->opt_include_unique, udp->opt_preserve, udp->opt_manual_prompt, udp->opt_auto_prompt);
+        GVariant *value = g_variant_new ("(bbbbbybbybb)", udp->opt_include_hidden, udp->opt_include_directory, udp->opt_include_empty, udp->opt_include_duplicate, udp->opt_include_unique, udp->opt_preserve, udp->opt_manual_prompt, udp->opt_auto_prompt, udp->opt_hash, udp->opt_drop_cache, udp->opt_verify);
 
         // Serialize for writing
         int sz = g_variant_get_size (value);
@@ -192,6 +194,52 @@ void auto_p_cb(GtkCheckButton *self, user_data *udp)
 		udp->opt_auto_prompt = FALSE;
 }	
 
+// Callback for hash engine options
+
+void sha256_cb(GtkCheckButton *self, user_data *udp)
+{
+	gtk_widget_set_sensitive(udp->save_button, TRUE);
+	udp->opt_hash = HA_SHA256;
+}
+
+// Callback for hash engine options
+
+void blake3_cb(GtkCheckButton *self, user_data *udp)
+{
+	gtk_widget_set_sensitive(udp->save_button, TRUE);
+	udp->opt_hash = HA_BLAKE3;
+}
+
+// Callback for hash engine options
+
+void xxh3_cb(GtkCheckButton *self, user_data *udp)
+{
+	gtk_widget_set_sensitive(udp->save_button, TRUE);
+	udp->opt_hash = HA_XXH3;
+}
+
+// Callback for page cache option
+
+void drop_cache_cb(GtkCheckButton *self, user_data *udp)
+{
+	gtk_widget_set_sensitive(udp->save_button, TRUE);
+	if (gtk_check_button_get_active(self))
+		udp->opt_drop_cache = TRUE;
+	else
+		udp->opt_drop_cache = FALSE;
+}
+
+// Callback for verify option
+
+void verify_cb(GtkCheckButton *self, user_data *udp)
+{
+	gtk_widget_set_sensitive(udp->save_button, TRUE);
+	if (gtk_check_button_get_active(self))
+		udp->opt_verify = TRUE;
+	else
+		udp->opt_verify = FALSE;
+}
+
 // Display the options window
 
 void work_options_cb(GSimpleAction *self, GVariant *parm, user_data *udp)
@@ -212,6 +260,10 @@ void work_options_cb(GSimpleAction *self, GVariant *parm, user_data *udp)
 	gtk_label_set_markup(GTK_LABEL(auto_preserve), "<b>\nAuto Preserve Options\n</b>");
 	gtk_label_set_xalign(GTK_LABEL(auto_preserve), 0.5);
 
+	GtkWidget *hash = gtk_label_new(NULL);
+	gtk_label_set_markup(GTK_LABEL(hash), "<b>\nHashing Options\n</b>");
+	gtk_label_set_xalign(GTK_LABEL(hash), 0.5);
+
 	GtkWidget *prompts = gtk_label_new(NULL);
 	gtk_label_set_markup(GTK_LABEL(prompts), "<b>\nTrash Confirmation Prompt Options\n</b>");
 	gtk_label_set_xalign(GTK_LABEL(prompts), 0.5);
@@ -231,6 +283,13 @@ void work_options_cb(GSimpleAction *self, GVariant *parm, user_data *udp)
 	GtkWidget *a = gtk_check_button_new_with_label("First Name Ascending");
 	GtkWidget *d = gtk_check_button_new_with_label("First Name Descending");
 
+	GtkWidget *sha256 = gtk_check_button_new_with_label(hash_algo_name(HA_SHA256));
+	GtkWidget *blake3 = gtk_check_button_new_with_label(hash_algo_name(HA_BLAKE3));
+	GtkWidget *xxh3 = gtk_check_button_new_with_label("XXH3-128 (trusted local data only)");
+
+	GtkWidget *drop_cache = gtk_check_button_new_with_label("Drop Hashed Files From Page Cache");
+	GtkWidget *verify = gtk_check_button_new_with_label("Verify Byte For Byte (no full hash)");
+
 	GtkWidget *manual_prompt = gtk_check_button_new_with_label("Prompt Manual Selection");
 	GtkWidget *auto_prompt = gtk_check_button_new_with_label("Prompt Auto Selection");
 
@@ -273,6 +332,22 @@ void work_options_cb(GSimpleAction *self, GVariant *parm, user_data *udp)
 	else if (udp->opt_preserve == AP_DESCENDING)
 		gtk_check_button_set_active((GtkCheckButton *) d, TRUE);
 
+	if (udp->opt_hash == HA_BLAKE3)
+		gtk_check_button_set_active((GtkCheckButton *) blake3, TRUE);
+	else if (udp->opt_hash == HA_XXH3)
+		gtk_check_button_set_active((GtkCheckButton *) xxh3, TRUE);
+	else
+		gtk_check_button_set_active((GtkCheckButton *) sha256, TRUE);
+
+	if (udp->opt_drop_cache)
+		gtk_check_button_set_active((GtkCheckButton *) drop_cache, TRUE);
+	if (udp->opt_verify)
+		gtk_check_button_set_active((GtkCheckButton *) verify, TRUE);
+
+	// Engines not built in can't be picked
+	gtk_widget_set_sensitive(blake3, hash_algo_built(HA_BLAKE3));
+	gtk_widget_set_sensitive(xxh3, hash_algo_built(HA_XXH3));
+
 	if (udp->opt_manual_prompt)
 		gtk_check_button_set_active((GtkCheckButton *) manual_prompt, TRUE);
 	else
@@ -290,6 +365,10 @@ void work_options_cb(GSimpleAction *self, GVariant *parm, user_data *udp)
 	gtk_check_button_set_group(GTK_CHECK_BUTTON(a), GTK_CHECK_BUTTON(mod_first));
 	gtk_check_button_set_group(GTK_CHECK_BUTTON(d), GTK_CHECK_BUTTON(mod_first));
 
+	// Create check button group for hash engine options
+	gtk_check_button_set_group(GTK_CHECK_BUTTON(blake3), GTK_CHECK_BUTTON(sha256));
+	gtk_check_button_set_group(GTK_CHECK_BUTTON(xxh3), GTK_CHECK_BUTTON(sha256));
+
 	// Setup callbacks
 	g_signal_connect(hidden, "toggled", G_CALLBACK(hidden_cb), udp);
 	g_signal_connect(directory, "toggled", G_CALLBACK(directory_cb), udp);
@@ -305,6 +384,12 @@ void work_options_cb(GSimpleAction *self, GVariant *parm, user_data *udp)
 	g_signal_connect(a, "toggled", G_CALLBACK(a_cb), udp);
 	g_signal_connect(d, "toggled", G_CALLBACK(d_cb), udp);
 
+	g_signal_connect(sha256, "toggled", G_CALLBACK(sha256_cb), udp);
+	g_signal_connect(blake3, "toggled", G_CALLBACK(blake3_cb), udp);
+	g_signal_connect(xxh3, "toggled", G_CALLBACK(xxh3_cb), udp);
+	g_signal_connect(drop_cache, "toggled", G_CALLBACK(drop_cache_cb), udp);
+	g_signal_connect(verify, "toggled", G_CALLBACK(verify_cb), udp);
+
 	g_signal_connect(manual_prompt, "toggled", G_CALLBACK(manual_p_cb), udp);
 	g_signal_connect(auto_prompt, "toggled", G_CALLBACK(auto_p_cb), udp);
 
@@ -327,6 +412,13 @@ void work_options_cb(GSimpleAction *self, GVariant *parm, user_data *udp)
 	gtk_box_append(GTK_BOX(box), a);
 	gtk_box_append(GTK_BOX(box), d);
 
+	gtk_box_append(GTK_BOX(box), hash);
+	gtk_box_append(GTK_BOX(box), sha256);
+	gtk_box_append(GTK_BOX(box), blake3);
+	gtk_box_append(GTK_BOX(box), xxh3);
+	gtk_box_append(GTK_BOX(box), drop_cache);
+	gtk_box_append(GTK_BOX(box), verify);
+
 	gtk_box_append(GTK_BOX(box), prompts);
 	gtk_box_append(GTK_BOX(box), manual_prompt);
 	gtk_box_append(GTK_BOX(box), auto_prompt);
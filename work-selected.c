@@ -16,6 +16,7 @@
 // along with this program.  If not, see <https:www.gnu.org/licenses/>.
 
 #include "main.h"
+#include "dup-model.h"
 #include "view-file.h"
 #include "work-trash.h"
 #include "lib.h"
@@ -23,16 +24,14 @@
 
 // Count the number of selected items with a specific result
 
-int count_selected_result (GtkBitset *bitset, GListStore *list_store, const char *result)
+int count_selected_result (GtkBitset *bitset, DupModel *list_store, int kind)
 {
         GtkBitsetIter iter;
         uint32_t value = 0;
         uint32_t hit = 0;
         gtk_bitset_iter_init_first(&iter, bitset, &value);
         do {
-                DupItem *item = g_list_model_get_item(G_LIST_MODEL(list_store), value);
-                if (!strncmp(item->result, result, strlen(result))) hit++;
-                g_object_unref(item);
+                if (dup_model_rec(list_store, value)->kind == kind) hit++;
 
         } while (gtk_bitset_iter_next(&iter, &value));
 
@@ -50,7 +49,7 @@ void work_trash_cb (GtkWidget *self, user_data *udp)
         gtk_window_close(GTK_WINDOW(udp->action_window));
 
         // A directory trash should be associated with just one request
-        if (gtk_bitset_get_size(udp->sel_bitset) > 1 && count_selected_result(udp->sel_bitset, udp->list_store, STR_DIR) > 0) {
+        if (gtk_bitset_get_size(udp->sel_bitset) > 1 && count_selected_result(udp->sel_bitset, udp->list_store, RK_DIR) > 0) {
                 GtkAlertDialog *alert = gtk_alert_dialog_new("Directory removals must be one at a time");
                 gtk_alert_dialog_show(alert, GTK_WINDOW(udp->main_window));
                 wipe_selected(udp); // Clear selected
@@ -58,7 +57,7 @@ void work_trash_cb (GtkWidget *self, user_data *udp)
         }
 
 	// Don't try to trash error entries
-	if (gtk_bitset_get_size(udp->sel_bitset) > 0 && count_selected_result(udp->sel_bitset, udp->list_store, STR_ERR) > 0) {
+	if (gtk_bitset_get_size(udp->sel_bitset) > 0 && count_selected_result(udp->sel_bitset, udp->list_store, RK_ERROR) > 0) {
                 GtkAlertDialog *alert = gtk_alert_dialog_new("Can not trash error entries");
                 gtk_alert_dialog_show(alert, GTK_WINDOW(udp->main_window));
                 wipe_selected(udp); // Clear selected
@@ -81,11 +80,11 @@ void view_cb (GtkCheckButton *self, user_data *udp)
 	gtk_window_close(GTK_WINDOW(udp->action_window));
 
 	// Get the selected item
-	udp->sel_item = g_list_model_get_item(G_LIST_MODEL(udp->list_store), gtk_bitset_get_minimum(udp->sel_bitset));
+	udp->sel_item = dup_model_rec(udp->list_store, gtk_bitset_get_minimum(udp->sel_bitset));
 
 	// Just view files
 	if (gtk_check_button_get_active(self)) {
-		if (strcmp(udp->sel_item->result, STR_DIR) || strncmp(udp->sel_item->result, STR_ERR, 5)) {
+		if (udp->sel_item->kind != RK_DIR && udp->sel_item->kind != RK_ERROR) {
 			view_file(udp);
 		}
 		else {
@@ -107,12 +106,12 @@ void copy_cb (GtkCheckButton *self, user_data *udp)
 
 	GdkClipboard *clippy = gtk_widget_get_clipboard(udp->main_window);
 	udp->clippy = clippy;
+	char path[STR_PATH] = { 0x00 };
 
 	// Easy case is just 1
 	if (gtk_bitset_get_size(udp->sel_bitset) == 1) {
-		DupItem *item = g_list_model_get_item(G_LIST_MODEL(udp->list_store),
-						      gtk_bitset_get_minimum(udp->sel_bitset));
-		gdk_clipboard_set_text(clippy, item->name);
+		dup_rec *item = dup_model_rec(udp->list_store, gtk_bitset_get_minimum(udp->sel_bitset));
+		gdk_clipboard_set_text(clippy, item_path(item, udp, path));
 		wipe_selected(udp);
 		return;
 	}
@@ -127,15 +126,15 @@ void copy_cb (GtkCheckButton *self, user_data *udp)
 	// Start the text to copy
 	char *clip_text = g_malloc0(STR_CLIP);
 	char *work = g_malloc0(STR_PATH);
-	DupItem *item = g_list_model_get_item(G_LIST_MODEL(udp->list_store), value);
-	snprintf(clip_text, sizeof(clip_text), "%s\n", item->name);
+	dup_rec *item = dup_model_rec(udp->list_store, value);
+	snprintf(clip_text, STR_CLIP, "%s\n", item_path(item, udp, path));
 
 	// Loop through the bitset
 	while (gtk_bitset_iter_next(&iter, &value)) {
 		value = gtk_bitset_iter_get_value(&iter);
-		item = g_list_model_get_item(G_LIST_MODEL(udp->list_store), value); // Get the selected item
+		item = dup_model_rec(udp->list_store, value); // Get the selected item
 
-		snprintf(work, sizeof(work), "%s\n", item->name); // Next name to add
+		snprintf(work, STR_PATH, "%s\n", item_path(item, udp, path)); // Next name to add
 
 		// Don't overrun size of text buffer for clipboard
 		if ((strlen(clip_text) + strlen(work) + 1) > STR_CLIP) {
@@ -174,11 +173,11 @@ void launch_cb (GtkCheckButton *self, user_data *udp)
 	gtk_window_close(GTK_WINDOW(udp->action_window));
 
 	// Get the selected item
-	DupItem *item = g_list_model_get_item(G_LIST_MODEL(udp->list_store),
-					      gtk_bitset_get_minimum(udp->sel_bitset));
+	dup_rec *item = dup_model_rec(udp->list_store, gtk_bitset_get_minimum(udp->sel_bitset));
 
 	// Launch the application
-	GFile *file = g_file_new_for_path(item->name);
+	char path[STR_PATH] = { 0x00 };
+	GFile *file = g_file_new_for_path(item_path(item, udp, path));
 	GtkFileLauncher *file_launcher = gtk_file_launcher_new(file);
 	gtk_file_launcher_set_file(file_launcher, file);
 	g_object_unref(file);
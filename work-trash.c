@@ -16,6 +16,7 @@
 // along with this program.  If not, see <https:www.gnu.org/licenses/>.
 
 #include "main.h"
+#include "dup-model.h"
 #include "lib.h"
 #include "work-trash.h"
 
@@ -30,6 +31,7 @@ void trash_em (user_data *udp)
         guint value = 0;
         gtk_bitset_iter_init_first(&iter, udp->sel_bitset, &value);
         GFile *gf = NULL;
+	char path[STR_PATH] = { 0x00 };
 
 	// Use a spinner to show activity if needed
 	guint64 cnt = gtk_bitset_get_size (udp->sel_bitset);
@@ -42,8 +44,8 @@ void trash_em (user_data *udp)
 	// Loop through biset, trashing each item
         do {
 		do_pending();
-                DupItem *item = g_list_model_get_item(G_LIST_MODEL(udp->list_store), value);
-                gf = g_file_new_for_path(item->name); // Get the name
+                dup_rec *item = dup_model_rec(udp->list_store, value);
+                gf = g_file_new_for_path(item_path(item, udp, path)); // Get the name
                 if (!g_file_trash(gf, NULL, NULL)) {
                         GtkAlertDialog *alert = gtk_alert_dialog_new("Can't trash entry");
                         gtk_alert_dialog_show(alert, GTK_WINDOW(udp->main_window));
@@ -51,7 +53,6 @@ void trash_em (user_data *udp)
                         return;
 		}	
                 g_object_unref(gf);
-                g_object_unref(item);
 
         } while (gtk_bitset_iter_next(&iter, &value));
 
@@ -67,7 +68,7 @@ void trash_em (user_data *udp)
         clear_stores(udp); // Clear the stores and associated item memory
 
 	// Reinitial store following clear (errors to stdout otherwise)
-	GListStore *list_store = g_list_store_new(G_TYPE_OBJECT);
+	DupModel *list_store = dup_model_new(NULL);
         udp->list_store = list_store; // Save pointer to list store
 
         return;